@@ -0,0 +1,13 @@
+#version 410 core
+
+// ends of the object space contour segments
+layout (location = 0) in vec3 vPos;
+
+#include "../frame_uniforms.glsl"
+
+void main()
+{
+	gl_Position = mvp * vec4(vPos, 1.0f);
+	// the lines lie on the surface : pulled slightly toward the camera to pass the depth test
+	gl_Position.z -= 0.0005f * gl_Position.w;
+}
\ No newline at end of file
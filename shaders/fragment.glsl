@@ -1,11 +1,50 @@
 #version 410 core
 
+// variant selected by the application (Shader defines), defaults to every contour family
+// SHADING_MODE 0: color, 1: gaussian curvature, 2: mean curvature, 3: suggestive contours
+#ifndef SHADING_MODE
+#define SHADING_MODE 3
+#endif
+#ifndef TRUE_CONTOURS
+#define TRUE_CONTOURS 1
+#endif
+#ifndef SUGGESTIVE_CONTOURS
+#define SUGGESTIVE_CONTOURS 1
+#endif
+// color mode only : the vertex shader gives the barycentric coordinates, else the mesh is drawn plain
+#ifndef WIREFRAME
+#define WIREFRAME 0
+#endif
+
 struct PointLight
 {
 	vec3 position;
 	vec3 color;
 };
 
+out vec4 color;
+
+#include "frame_uniforms.glsl"
+
+#if SHADING_MODE == 0
+#if WIREFRAME
+noperspective in vec3 barycentric; // screen space, from the vertex shader
+const float wireframe_half_width = 0.75f; // pixels on each side of an edge
+
+// 0 on the edges of the triangle, 1 inside
+float wireframe()
+{
+	vec3 edge = smoothstep(vec3(0.0f), fwidth(barycentric) * wireframe_half_width, barycentric);
+	return min(edge.x, min(edge.y, edge.z));
+}
+#else
+// the buffer textures do not cover the mesh
+float wireframe()
+{
+	return 1.0f;
+}
+#endif
+#else
 in VS_OUT
 {
 	vec3 fragNormal;
@@ -22,22 +61,8 @@ in VS_OUT
 
 const vec3 gradient_color = vec3(1.0f);
 
-out vec4 color;
-
-uniform float minKg;
-uniform float maxKg;
-uniform float minH;
-uniform float maxH;
-
-uniform vec3 objectColor;
-uniform vec3 viewPosition;
-uniform bool draw_true_contours;
-uniform bool draw_suggestive_contours;
 uniform bool draw_strong_suggestive_contours;
 
-uniform int shading_mode; // 0: color, 1: gaussian curvature, 2: mean curvature
-uniform float max_Kn; // accept from 0.0f to this value
-
 vec3 project_viewDir_on_tangent_plane()
 {
 	vec3 viewDir = viewPosition - fs_in.fragPos;
@@ -108,88 +133,44 @@ bool keep_fragment(float DwKn_mag)
 	}
 	return false;
 }
+#endif
 
 void main()
 {
-	struct PointLight light;
+	PointLight light;
 	light.position = vec3(10.0f, 10.0f, 10.0f);
 	light.color = vec3(1.0f, 1.0f, 1.0f);
 
-	if(shading_mode == 0)
-	{
-		color = vec4(objectColor, 1.0f);
-	}
-	else if(shading_mode == 1)
-	{
-		color = vec4(gradient_gaussian_curvature(), 1.0f);
-	}
-	else if(shading_mode == 2)
+#if SHADING_MODE == 0
+	color = vec4(objectColor * wireframe(), 1.0f);
+#elif SHADING_MODE == 1
+	color = vec4(gradient_gaussian_curvature(), 1.0f);
+#elif SHADING_MODE == 2
+	color = vec4(gradient_mean_curvature(), 1.0f);
+#else
+	color = vec4(objectColor, 1.0f);
+#if TRUE_CONTOURS
+	if(true_contour())
 	{
-		color = vec4(gradient_mean_curvature(), 1.0f);
+		color = vec4(vec3(0.0f), 1.0f);
+		return;
 	}
-	else
+#endif
+#if SUGGESTIVE_CONTOURS
+	vec3 w = project_viewDir_on_tangent_plane();
+	float theta = compute_angle_between_vectors(w, fs_in.fT1);
+	float Kn = fs_in.fK1 * pow(cos(theta), 2.0f) + fs_in.fK2 * pow(sin(theta), 2.0f);
+	float DwKn = derivative_radial_curvature_along_w(w);
+	float derivative_magnitude = DwKn / length(w);
+#if TRUE_CONTOURS
+	bool radial_range = Kn >= 0.0f && Kn <= max_Kn;
+#else
+	bool radial_range = Kn > 0.0f && Kn <= max_Kn;
+#endif
+	if(radial_range && (DwKn > 0.0f) && keep_fragment(derivative_magnitude))
 	{
-		vec3 w = project_viewDir_on_tangent_plane();
-		float theta = compute_angle_between_vectors(w, fs_in.fT1);
-		float Kn = fs_in.fK1 * pow(cos(theta), 2.0f) + fs_in.fK2 * pow(sin(theta), 2.0f);
-		float DwKn = derivative_radial_curvature_along_w(w);
-		float derivative_magnitude = DwKn / length(w);
-
-		if(draw_true_contours && !draw_suggestive_contours)
-		{
-			if(true_contour())
-			{
-				color = vec4(vec3(0.0f), 1.0f);
-			}
-			else
-			{
-				color = vec4(objectColor, 1.0f);
-			}
-		}
-		else if(!draw_true_contours && draw_suggestive_contours)
-		{
-			if((Kn > 0.0f && Kn <= max_Kn) && (DwKn > 0.0f))
-			{
-				if(keep_fragment(derivative_magnitude))
-				{
-					color = vec4(vec3(0.0f), 1.0f);
-				}
-				else
-				{
-					color = vec4(objectColor, 1.0f);
-				}
-			}
-			else
-			{
-				color = vec4(objectColor, 1.0f);
-			}
-		}
-		else if(draw_true_contours && draw_suggestive_contours)
-		{
-			if(true_contour())
-			{
-				color = vec4(vec3(0.0f), 1.0f);
-			}
-
-			else if((Kn >= 0.0f && Kn <= max_Kn) && (DwKn > 0.0f))
-			{
-				if(keep_fragment(derivative_magnitude))
-				{
-					color = vec4(vec3(0.0f), 1.0f);
-				}
-				else
-				{
-					color = vec4(objectColor, 1.0f);
-				}
-			}
-			else
-			{
-				color = vec4(objectColor, 1.0f);
-			}
-		}
-		else
-		{
-			color = vec4(objectColor, 1.0f);
-		}
+		color = vec4(vec3(0.0f), 1.0f);
 	}
+#endif
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,15 @@
+// values shared by every program, updated once per frame (FrameUniforms in src/shader.hpp)
+layout (std140) uniform Frame
+{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+	mat4 mvp; // proj * view * model
+	vec3 viewPosition;
+	float max_Kn; // accept from 0.0f to this value
+	vec3 objectColor;
+	float minKg;
+	float maxKg;
+	float minH;
+	float maxH;
+};
\ No newline at end of file
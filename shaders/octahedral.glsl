@@ -0,0 +1,8 @@
+// unit vector octahedral encoded by octahedral_encode in src/vertex_format.cpp
+vec3 octahedral_decode(vec2 e)
+{
+	vec3 d = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = max(-d.z, 0.0f);
+	d.xy += vec2(d.x >= 0.0f ? -t : t, d.y >= 0.0f ? -t : t);
+	return normalize(d);
+}
\ No newline at end of file
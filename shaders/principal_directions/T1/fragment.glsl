@@ -1,8 +0,0 @@
-#version 410 core
-
-out vec4 color;
-
-void main()
-{
-	color = vec4(1.0f, 0.0f, 0.0f, 1.0f);
-}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#version 410 core
+
+flat in vec3 glyphColor;
+
+out vec4 color;
+
+void main()
+{
+	color = vec4(glyphColor, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 410 core
+
+// one instance per drawn vertex : vertices 0 and 1 span T1, 2 and 3 span T2
+layout (location = 0) in vec3 vPos;
+layout (location = 6) in vec2 vT1; // octahedral
+layout (location = 7) in vec2 vT2; // octahedral
+
+#include "../frame_uniforms.glsl"
+
+flat out vec3 glyphColor;
+
+#include "../octahedral.glsl"
+
+void main()
+{
+	const float scale = 0.35f;
+	bool T1 = gl_VertexID < 2;
+	vec3 direction = octahedral_decode(T1 ? vT1 : vT2);
+	float side = ((gl_VertexID & 1) == 0) ? 1.0f : -1.0f;
+	gl_Position = mvp * vec4(vPos + side * scale * direction, 1.0f);
+	glyphColor = T1 ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 0.0f, 1.0f); // T1 red, T2 blue
+}
\ No newline at end of file
@@ -1,19 +1,38 @@
 #version 410 core
 
+// WIREFRAME 1 : one vertex per triangle corner, set by the application for the color mode
+#ifndef WIREFRAME
+#define WIREFRAME 0
+#endif
+
+#include "frame_uniforms.glsl"
+
+#if WIREFRAME
+// wireframe drawn by the main pass : glDrawArrays over the index count, without attributes. Each corner
+// reads its vertex through the index and vertex buffers and carries its own barycentric coordinate.
+uniform samplerBuffer vertex_data; // PackedVertex buffer as float pairs
+uniform usamplerBuffer triangle_corners; // index buffer, one RGB texel per triangle
+const int packed_vertex_texels = 5; // sizeof(PackedVertex) / 8, the position comes first
+
+noperspective out vec3 barycentric;
+
+void main()
+{
+	int corner = gl_VertexID % 3;
+	int v = int(texelFetch(triangle_corners, gl_VertexID / 3)[corner]) * packed_vertex_texels;
+	vec3 position = vec3(texelFetch(vertex_data, v).xy, texelFetch(vertex_data, v + 1).x);
+	gl_Position = mvp * vec4(position, 1.0f);
+	barycentric = vec3(0.0f);
+	barycentric[corner] = 1.0f;
+}
+#else
 layout (location = 0) in vec3 position;
-layout (location = 1) in vec3 normal;
-layout(location = 2) in vec3 tangent_U;
-layout(location = 3) in vec3 tangent_V;
-layout (location = 4) in float K1;
-layout (location = 5) in float K2;
-layout (location = 6) in vec3 T1;
-layout (location = 7) in vec3 T2;
-layout (location = 8) in mat2 C1; // front slice of C matrix
-layout (location = 9) in mat2 C2; // back slice of C matrix
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
+layout (location = 1) in vec2 normal; // octahedral
+layout (location = 2) in vec2 tangent_U; // octahedral
+layout (location = 4) in vec2 K; // K1, K2
+layout (location = 6) in vec2 T1; // octahedral
+layout (location = 7) in vec2 T2; // octahedral
+layout (location = 8) in vec4 C; // a, b, c, d of the C tensor
 
 out VS_OUT
 {
@@ -29,17 +48,22 @@ out VS_OUT
 	mat2 C2;
 } vs_out;
 
+#include "octahedral.glsl"
+
 void main()
 {
-	gl_Position = proj * view * model * vec4(position, 1.0f);
+	gl_Position = mvp * vec4(position, 1.0f);
 	vs_out.fragPos = position;
-	vs_out.fragNormal = normal;
-	vs_out.tangent_U = tangent_U;
-	vs_out.tangent_V = tangent_V;
-	vs_out.fK1 = K1;
-	vs_out.fK2 = K2;
-	vs_out.fT1 = T1;
-	vs_out.fT2 = T2;
-	vs_out.C1 = C1;
-	vs_out.C2 = C2;
-}
\ No newline at end of file
+	vec3 n = octahedral_decode(normal);
+	vec3 u = octahedral_decode(tangent_U);
+	vs_out.fragNormal = n;
+	vs_out.tangent_U = u;
+	vs_out.tangent_V = cross(n, u); // (U, V, N) is a direct frame
+	vs_out.fK1 = K.x;
+	vs_out.fK2 = K.y;
+	vs_out.fT1 = octahedral_decode(T1);
+	vs_out.fT2 = octahedral_decode(T2);
+	vs_out.C1 = mat2(C.x, C.y, C.y, C.z); // front slice of C matrix
+	vs_out.C2 = mat2(C.y, C.z, C.z, C.w); // back slice of C matrix
+}
+#endif
\ No newline at end of file
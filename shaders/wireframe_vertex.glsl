@@ -1,12 +0,0 @@
-#version 410 core
-
-layout (location = 0) in vec3 position;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
-
-void main()
-{
-	gl_Position = proj * view * model * vec4(position, 1.0f);
-}
\ No newline at end of file
@@ -61,7 +61,12 @@ struct UI
 	bool draw_T2;
 	bool draw_true_contours;
 	bool draw_suggestive_contours;
+	bool object_space_contours; // suggestive contours and silhouettes extracted on the CPU and drawn as lines
+	bool edge_silhouettes; // mesh edges between front and back faces instead of the smooth silhouette
 	float object_color[3];
 	int shading_mode;
 	float max_Kn;
+	float contour_min_DwKn; // object space contours : t_d and theta_c (degrees) of DeCarlo et al.
+	float contour_min_angle;
+	float glyph_spacing; // pixels between principal direction glyphs, 0 draws one per vertex
 };
\ No newline at end of file
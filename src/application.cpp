@@ -1,11 +1,82 @@
 #include "application.h"
 
-App::App() :
+App::App(MeshOptions const& iMeshOptions) :
 	m_cam(glm::vec3(0.0f, 0.0f, 30.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), static_cast<float>(WIDTH) / static_cast<float>(HEIGHT)),
-	m_wireframeShader("shaders/wireframe_vertex.glsl", "shaders/wireframe_geometry.glsl", "shaders/wireframe_fragment.glsl"),
-	m_principalDirT1("shaders/principal_directions/T1/vertex.glsl", "shaders/principal_directions/T1/geometry.glsl", "shaders/principal_directions/T1/fragment.glsl"),
-	m_principalDirT2("shaders/principal_directions/T2/vertex.glsl", "shaders/principal_directions/T2/geometry.glsl", "shaders/principal_directions/T2/fragment.glsl"),
-	m_mesh("assets/stanford_bunny_high_poly.obj")
+	m_principalDirections("shaders/principal_directions/vertex.glsl", "shaders/principal_directions/fragment.glsl"),
+	m_contourLines("shaders/contour_lines/vertex.glsl", "shaders/contour_lines/fragment.glsl"),
+	m_mesh("assets/stanford_bunny_high_poly.obj", iMeshOptions)
 {
-	m_mainShader = std::make_shared<Shader>("shaders/vertex.glsl", "shaders/fragment.glsl");
+	glGenBuffers(1, &m_frameUbo);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_frameUbo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, g_frameUniformBinding, m_frameUbo);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+App::~App()
+{
+	glDeleteBuffers(1, &m_frameUbo);
+}
+
+// camera, mesh and UI values read by the programs, uploaded in one go
+void App::update_frame_uniforms(struct UI const& iUI)
+{
+	FrameUniforms frame;
+	frame.m_model = m_mesh.m_model;
+	frame.m_view = m_cam.m_view;
+	frame.m_proj = m_cam.m_proj;
+	frame.m_mvp = m_cam.m_proj * m_cam.m_view * m_mesh.m_model;
+	frame.m_viewPosition = m_cam.m_position;
+	frame.m_max_Kn = iUI.max_Kn;
+	frame.m_objectColor = glm::vec3(iUI.object_color[0], iUI.object_color[1], iUI.object_color[2]);
+	frame.m_minKg = m_mesh.m_geom.m_minKg;
+	frame.m_maxKg = m_mesh.m_geom.m_maxKg;
+	frame.m_minH = m_mesh.m_geom.m_minH;
+	frame.m_maxH = m_mesh.m_geom.m_maxH;
+	frame.m_padding = 0;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_frameUbo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), &frame, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+// the main program compiled with only the code of the shading mode and contour families shown
+Shader& App::main_shader(struct UI const& iUI)
+{
+	bool contours = iUI.shading_mode == SM_SUGGESTIVE_CONTOURS;
+	int true_contours = (contours && iUI.draw_true_contours && !iUI.object_space_contours) ? 1 : 0;
+	int suggestive_contours = (contours && iUI.draw_suggestive_contours && !iUI.object_space_contours) ? 1 : 0;
+	int wireframe = (iUI.shading_mode == SM_COLOR && m_mesh.m_wireframe) ? 1 : 0;
+	int variant = iUI.shading_mode | (true_contours << 2) | (suggestive_contours << 3) | (wireframe << 4);
+
+	std::shared_ptr<Shader>& shader = m_mainShaders[variant];
+	if (!shader)
+	{
+		std::vector<std::string> defines = {
+			"SHADING_MODE " + std::to_string(iUI.shading_mode),
+			"TRUE_CONTOURS " + std::to_string(true_contours),
+			"SUGGESTIVE_CONTOURS " + std::to_string(suggestive_contours),
+			"WIREFRAME " + std::to_string(wireframe) };
+		shader = std::make_shared<Shader>("shaders/vertex.glsl", "shaders/fragment.glsl", defines);
+		glUseProgram(shader->m_program);
+		shader->setInt(shader->uniformLocation("vertex_data"), g_vertexTextureUnit);
+		shader->setInt(shader->uniformLocation("triangle_corners"), g_indexTextureUnit);
+		glUseProgram(0);
+	}
+	return *shader;
+}
+
+// vertex stride that leaves about iSpacing pixels between glyphs : the mesh covers about the disk
+// of its bounding sphere on screen, with the vertices facing the camera, about half, spread over it
+int App::glyph_stride(float iSpacing) const
+{
+	if (iSpacing <= 0.0f) { return 1; }
+
+	float distance = glm::length(m_cam.m_position - m_mesh.m_center);
+	if (distance <= m_mesh.m_radius) { return 1; }
+	float radius_pixels = m_mesh.m_radius / distance * m_cam.m_proj[1][1] * 0.5f * static_cast<float>(m_viewport.m_height);
+	float disk_pixels = static_cast<float>(M_PI) * radius_pixels * radius_pixels;
+	float visible_vertices = 0.5f * static_cast<float>(m_mesh.m_geom.m_vertex.size());
+	float stride = visible_vertices * iSpacing * iSpacing / std::max(disk_pixels, 1.0f);
+	return std::min(std::max(static_cast<int>(std::ceil(stride)), 1), g_maxGlyphStride);
 }
\ No newline at end of file
@@ -18,14 +18,18 @@ struct FBO
 
 struct App
 {
-	App();
+	App(MeshOptions const& iMeshOptions);
+	~App();
+	void update_frame_uniforms(struct UI const& iUI);
+	Shader& main_shader(struct UI const& iUI);
+	int glyph_stride(float iSpacing) const;
 
 	Camera m_cam;
-	std::shared_ptr<Shader> m_mainShader;
-	Shader m_wireframeShader;
-	Shader m_principalDirT1;
-	Shader m_principalDirT2;
+	std::unordered_map<int, std::shared_ptr<Shader>> m_mainShaders;	// fragment shader variants, built on first use
+	Shader m_principalDirections;
+	Shader m_contourLines;		// object space suggestive contours and silhouettes
 	Mesh m_mesh;
 	struct Mouse m_mouse;
 	struct Viewport m_viewport;
+	GLuint m_frameUbo;		// FrameUniforms shared by every program
 };
\ No newline at end of file
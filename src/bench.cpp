@@ -0,0 +1,761 @@
+#include "mesh.hpp"
+#include <Eigen/unsupported/Eigen/MatrixFunctions>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <unordered_map>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// headless benchmarks and checks of the geometry pipeline, no window
+// suggestive_contours_bench <mode> [mesh file] [mesh options]
+
+// how far setup_mesh runs the pipeline
+enum class MeshStage
+{
+	Loaded,			// loaded, cleaned up and reordered as the mesh options ask
+	Adjacency,		// and its adjacency
+	Curvatures		// and its normals, curvatures and their derivatives
+};
+
+// the mesh as the viewer prepares it, up to iStage
+bool setup_mesh(std::string const& iPath, MeshOptions const& iOptions, MeshStage iStage, Geometry& oGeom)
+{
+	if (!oGeom.load(iPath, ThreadPool::global()) || oGeom.m_face.empty())
+	{
+		std::cerr << "ERROR: " << iPath << " : no mesh loaded" << std::endl;
+		return false;
+	}
+	oGeom.cleanup(ThreadPool::global(), iOptions.m_cleanup);
+	if (iOptions.m_reorder) { oGeom.reorder(ThreadPool::global()); }
+	if (iOptions.m_draw_order) { oGeom.optimize_draw_order(); }
+	std::cout << iPath << " : " << oGeom.m_vertex.size() << " vertices, " << oGeom.m_face.size() << " faces" << std::endl;
+
+	if (iStage == MeshStage::Loaded) { return true; }
+	oGeom.compute_adjacency();
+	if (iStage == MeshStage::Adjacency) { return true; }
+	oGeom.compute_curvatures(ThreadPool::global());
+	return true;
+}
+
+template<typename T>
+bool same_bits(std::vector<T> const& a, std::vector<T> const& b)
+{
+	return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+// one-ring of iVertex the way Mesh::get_neighbors built it before the compressed adjacency :
+// a scan of every face, then a linear search to skip the vertices already stored
+void quadratic_one_ring(Geometry const& iGeom, int iVertex, std::vector<int>& oVertices)
+{
+	oVertices.clear();
+	auto add = [&](int v)
+	{
+		if (std::find(oVertices.begin(), oVertices.end(), v) == oVertices.end()) { oVertices.push_back(v); }
+	};
+	for (glm::ivec3 const& face : iGeom.m_face)
+	{
+		if (iVertex == face.x) { add(face.y); add(face.z); }
+		else if (iVertex == face.y) { add(face.x); add(face.z); }
+		else if (iVertex == face.z) { add(face.x); add(face.y); }
+	}
+}
+
+// time Geometry::compute_adjacency on grids of about 100k, 1M and 5M triangles against the former
+// per vertex face scan. The scan is quadratic, it is timed on a sample of vertices and extrapolated
+int adjacency_benchmark(std::string const&, MeshOptions const&)
+{
+	int const sizes[] = { 224, 707, 1581 };		// n x n quads, 2 n^2 triangles
+	int const samples = 16;
+	for (int n : sizes)
+	{
+		struct Geometry geom;
+		for (int y = 0; y <= n; ++y)
+		{
+			for (int x = 0; x <= n; ++x) { geom.m_vertex.emplace_back(0.05f * x, 0.05f * y, std::sin(0.05f * x) * std::cos(0.07f * y)); }
+		}
+		for (int y = 0; y < n; ++y)
+		{
+			for (int x = 0; x < n; ++x)
+			{
+				int a = y * (n + 1) + x;
+				int c = a + n + 1;
+				geom.m_face.emplace_back(a, a + 1, c + 1);
+				geom.m_face.emplace_back(a, c + 1, c);
+			}
+		}
+		std::cout << "grid : " << geom.m_vertex.size() << " vertices, " << geom.m_face.size() << " faces" << std::endl;
+
+		geom.compute_adjacency(); // warm up
+		int const runs = 3;
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r) { geom.compute_adjacency(); }
+		double csr_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+
+		bool identical = true;
+		std::vector<int> ring;
+		start = std::chrono::steady_clock::now();
+		for (int k = 0; k < samples; ++k)
+		{
+			int v = static_cast<int>((geom.m_vertex.size() - 1) * k / (samples - 1));
+			quadratic_one_ring(geom, v, ring);
+			IndexRange csr_ring = geom.m_vertex_vertices[v];
+			identical = identical && ring.size() == csr_ring.size() && std::equal(ring.begin(), ring.end(), csr_ring.begin());
+		}
+		double scan_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / samples;
+		double quadratic_ms = scan_ms * geom.m_vertex.size();
+
+		std::cout << "  compressed : " << csr_ms << " ms" << std::endl;
+		std::cout << "  quadratic : " << quadratic_ms / 1000.0 << " s (" << scan_ms << " ms per vertex on " << samples << " vertices), speedup "
+			<< quadratic_ms / csr_ms << (identical ? "" : " (ONE-RINGS DIFFER)") << std::endl;
+	}
+	return 0;
+}
+
+// corner table queries against scans of the faces : the opposite face and edge_faces of every corner
+// edge, is_boundary_vertex, and one_ring walking distinct corners of the vertex around a single fan
+int topology_check(std::string const& iPath, MeshOptions const& iOptions)
+{
+	struct Geometry geom;
+	if (!setup_mesh(iPath, iOptions, MeshStage::Adjacency, geom)) { return -1; }
+	CornerTable const& table = geom.m_corners;
+	size_t corner_count = table.m_corner_vertex.size();
+	uint64_t vertex_count = geom.m_vertex.size();
+
+	// faces holding each directed edge, in face order
+	std::unordered_map<uint64_t, std::vector<int>> edge_faces;
+	auto key = [&](int a, int b) { return static_cast<uint64_t>(a) * vertex_count + static_cast<uint64_t>(b); };
+	for (size_t c = 0; c < corner_count; ++c)
+	{
+		edge_faces[key(table.vertex(CornerTable::next(c)), table.vertex(CornerTable::prev(c)))].push_back(CornerTable::face(c));
+	}
+	auto faces_of = [&](int a, int b)
+	{
+		auto it = edge_faces.find(key(a, b));
+		return (it == edge_faces.end()) ? std::vector<int>() : it->second;
+	};
+	// one face each way : the only edges the table links
+	auto manifold = [&](int a, int b) { return a != b && faces_of(a, b).size() == 1 && faces_of(b, a).size() == 1; };
+
+	size_t edge_errors = 0;
+	std::vector<unsigned char> boundary(vertex_count, 0);
+	for (size_t c = 0; c < corner_count; ++c)
+	{
+		int a = table.vertex(CornerTable::next(c));
+		int b = table.vertex(CornerTable::prev(c));
+		std::vector<int> ab = faces_of(a, b);
+		std::vector<int> ba = faces_of(b, a);
+		int opposite = manifold(a, b) ? ba[0] : -1;
+		std::array<int, 2> faces = table.edge_faces(a, b);
+		if (table.opposite_face(c) != opposite || faces[0] != ab[0] || faces[1] != (ba.empty() ? -1 : ba[0])) { ++edge_errors; }
+		if (opposite == -1) { boundary[a] = boundary[b] = 1; }
+	}
+
+	size_t boundary_vertices = 0;
+	size_t boundary_errors = 0;
+	size_t ring_errors = 0;
+	size_t partial_rings = 0;
+	std::vector<int> last_visit(corner_count, -1);
+	for (size_t v = 0; v < vertex_count; ++v)
+	{
+		boundary_vertices += boundary[v];
+		if (table.is_boundary_vertex(v) != (boundary[v] != 0)) { ++boundary_errors; }
+
+		size_t visited = 0;
+		bool valid = true;
+		for (int c : table.one_ring(v))
+		{
+			valid = valid && table.vertex(c) == static_cast<int>(v) && last_visit[c] != static_cast<int>(v);
+			last_visit[c] = v;
+			if (!valid || ++visited > table.corners(v).size()) { valid = false; break; }
+		}
+		if (!valid) { ++ring_errors; }
+		else if (visited != table.corners(v).size()) { ++partial_rings; }
+	}
+
+	std::cout << corner_count / 3 << " faces, " << boundary_vertices << " boundary vertices, " << partial_rings
+		<< " vertices with more than one fan" << std::endl;
+	std::cout << "edge errors : " << edge_errors << ", boundary errors : " << boundary_errors << ", one-ring errors : " << ring_errors << std::endl;
+	bool passed = edge_errors == 0 && boundary_errors == 0 && ring_errors == 0;
+	std::cout << (passed ? "passed" : "FAILED") << std::endl;
+	return passed ? 0 : 1;
+}
+
+// Taubin smoothing against the dense filter it replaced, x' = ((I - lambda K)(I - mu K))^N x with
+// MatrixXd::pow in double precision. Fails when a vertex moves away from the dense result by more than
+// g_taubinTolerance times the bounding box diagonal
+constexpr double g_taubinTolerance = 1e-6;
+
+int taubin_check(std::string const& iPath, MeshOptions const& iOptions)
+{
+	struct Geometry geom;
+	if (!setup_mesh(iPath, iOptions, MeshStage::Adjacency, geom)) { return -1; }
+	geom.compute_circulant_matrix();
+
+	size_t count = geom.m_vertex.size();
+	Eigen::MatrixXd x(count, 3);
+	for (size_t i = 0; i < count; ++i)
+	{
+		x(i, 0) = geom.m_vertex[i].x;
+		x(i, 1) = geom.m_vertex[i].y;
+		x(i, 2) = geom.m_vertex[i].z;
+	}
+	double diagonal = (x.colwise().maxCoeff() - x.colwise().minCoeff()).norm();
+
+	auto start = std::chrono::steady_clock::now();
+	Eigen::MatrixXd I = Eigen::MatrixXd::Identity(count, count);
+	Eigen::MatrixXd K = I - Eigen::MatrixXd(geom.m_W.cast<double>());
+	Eigen::MatrixXd filter = (I - (geom.lambda * K)) * (I - (geom.mu * K));
+	Eigen::MatrixXd dense = Eigen::MatrixXd(filter.pow(geom.N)) * x;
+	double dense_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	geom.apply_taubin_filter();
+	double kernel_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	double max_error = 0.0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		Eigen::Vector3d p(geom.m_vertex[i].x, geom.m_vertex[i].y, geom.m_vertex[i].z);
+		max_error = std::max(max_error, (p - dense.row(i).transpose()).norm());
+	}
+	bool passed = max_error <= g_taubinTolerance * diagonal;
+	std::cout << "dense : " << dense_ms << " ms, kernel : " << kernel_ms << " ms" << std::endl;
+	std::cout << "max position error : " << max_error << ", " << max_error / diagonal << " of the bounding box diagonal "
+		<< (passed ? "(passed)" : "(FAILED)") << std::endl;
+	return passed ? 0 : 1;
+}
+
+// Taubin smoothing kernel for 1 to 8 threads against the scalar taubin_smoothing_reference, bit for bit
+int taubin_kernel_check(std::string const& iPath, MeshOptions const& iOptions)
+{
+	struct Geometry geom;
+	if (!setup_mesh(iPath, iOptions, MeshStage::Adjacency, geom)) { return -1; }
+	geom.compute_circulant_matrix();
+
+	std::vector<glm::vec3> reference = geom.m_vertex;
+	auto start = std::chrono::steady_clock::now();
+	taubin_smoothing_reference(geom.m_W, geom.lambda, geom.mu, geom.N, reference);
+	std::cout << "reference : " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+	bool passed = true;
+	for (unsigned int threads = 1; threads <= 8; ++threads)
+	{
+		ThreadPool pool(threads);
+		std::vector<glm::vec3> vertex = geom.m_vertex;
+		start = std::chrono::steady_clock::now();
+		taubin_smoothing_kernel(pool, geom.m_W, geom.lambda, geom.mu, geom.N, vertex);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		bool identical = same_bits(vertex, reference);
+		passed = passed && identical;
+		std::cout << threads << " threads : " << ms << " ms" << (identical ? "" : " (RESULTS DIFFER)") << std::endl;
+	}
+	return passed ? 0 : 1;
+}
+
+// per face Weingarten fit the way compute_per_face_weingarten_matrix solved it before the 2x2 normal
+// equations : a dynamic 6x4 least squares system through colPivHouseholderQr
+void qr_face_weingarten(Geometry& ioGeom, std::vector<glm::mat2>& oWeingarten)
+{
+	oWeingarten.resize(ioGeom.m_face.size());
+	for (size_t i = 0; i < ioGeom.m_face.size(); ++i)
+	{
+		glm::ivec3 const& face = ioGeom.m_face[i];
+		glm::vec3 v0 = ioGeom.m_vertex[face.x];
+		glm::vec3 n0 = ioGeom.m_vertex_normal[face.x];
+		glm::vec3 v1 = ioGeom.m_vertex[face.y];
+		glm::vec3 n1 = ioGeom.m_vertex_normal[face.y];
+		glm::vec3 v2 = ioGeom.m_vertex[face.z];
+		glm::vec3 n2 = ioGeom.m_vertex_normal[face.z];
+		glm::vec3 e0 = v1 - v0;
+		glm::vec3 e1 = v2 - v1;
+		glm::vec3 e2 = v0 - v2;
+
+		struct CoordSys cs;
+		cs.m_u = glm::normalize(e0);
+		cs.m_v = glm::normalize(glm::cross(cs.m_u, glm::cross(e1, -e0)));
+		cs.m_w = glm::normalize(glm::cross(e1, -e0));
+		ioGeom.m_face_coordSys[i] = cs;
+
+		Eigen::MatrixXf A = Eigen::MatrixXf::Zero(6, 4);
+		A(0, 0) = glm::dot(e0, cs.m_u); A(0, 1) = glm::dot(e0, cs.m_v);
+		A(1, 2) = glm::dot(e0, cs.m_u); A(1, 3) = glm::dot(e0, cs.m_v);
+		A(2, 0) = glm::dot(e1, cs.m_u); A(2, 1) = glm::dot(e1, cs.m_v);
+		A(3, 2) = glm::dot(e1, cs.m_u); A(3, 3) = glm::dot(e1, cs.m_v);
+		A(4, 0) = glm::dot(e2, cs.m_u); A(4, 1) = glm::dot(e2, cs.m_v);
+		A(5, 2) = glm::dot(e2, cs.m_u); A(5, 3) = glm::dot(e2, cs.m_v);
+
+		Eigen::MatrixXf b = Eigen::MatrixXf::Zero(6, 1);
+		b(0, 0) = glm::dot((n1 - n0), cs.m_u);
+		b(1, 0) = glm::dot((n1 - n0), cs.m_v);
+		b(2, 0) = glm::dot((n2 - n1), cs.m_u);
+		b(3, 0) = glm::dot((n2 - n1), cs.m_v);
+		b(4, 0) = glm::dot((n0 - n2), cs.m_u);
+		b(5, 0) = glm::dot((n0 - n2), cs.m_v);
+
+		Eigen::Vector4f x = A.colPivHouseholderQr().solve(b);
+		glm::mat2 m;
+		m[0][0] = x(0); m[0][1] = x(1);
+		m[1][0] = x(2); m[1][1] = x(3);
+		oWeingarten[i] = m;
+
+		glm::vec3 weights;
+		ioGeom.compute_face_mixed_voronoi_area(v0, v1, v2, weights);
+		ioGeom.m_face_weingarten_weights[i] = weights;
+	}
+}
+
+// per face C fit the way compute_per_face_C solved it before the 4x4 normal equations :
+// a dynamic 9x4 least squares system through colPivHouseholderQr
+void qr_face_C(Geometry const& iGeom, std::vector<MatCube>& oC)
+{
+	oC.resize(iGeom.m_face.size());
+	for (size_t i = 0; i < iGeom.m_face.size(); ++i)
+	{
+		glm::ivec3 const& face = iGeom.m_face[i];
+		glm::vec3 e0 = iGeom.m_vertex[face.y] - iGeom.m_vertex[face.x];
+		glm::vec3 e1 = iGeom.m_vertex[face.z] - iGeom.m_vertex[face.y];
+		glm::vec3 e2 = iGeom.m_vertex[face.x] - iGeom.m_vertex[face.z];
+		glm::mat2 sff_v0 = iGeom.m_vertex_weingarten[face.x];
+		glm::mat2 sff_v1 = iGeom.m_vertex_weingarten[face.y];
+		glm::mat2 sff_v2 = iGeom.m_vertex_weingarten[face.z];
+		struct CoordSys const& cs = iGeom.m_face_coordSys[i];
+
+		Eigen::MatrixXf A = Eigen::MatrixXf::Zero(9, 4);
+		A(0, 0) = glm::dot(e0, cs.m_u); A(0, 1) = glm::dot(e0, cs.m_v);
+		A(1, 1) = glm::dot(e0, cs.m_u); A(1, 2) = glm::dot(e0, cs.m_v);
+		A(2, 2) = glm::dot(e0, cs.m_u); A(2, 3) = glm::dot(e0, cs.m_v);
+		A(3, 0) = glm::dot(e1, cs.m_u); A(3, 1) = glm::dot(e1, cs.m_v);
+		A(4, 1) = glm::dot(e1, cs.m_u); A(4, 2) = glm::dot(e1, cs.m_v);
+		A(5, 2) = glm::dot(e1, cs.m_u); A(5, 3) = glm::dot(e1, cs.m_v);
+		A(6, 0) = glm::dot(e2, cs.m_u); A(6, 1) = glm::dot(e2, cs.m_v);
+		A(7, 1) = glm::dot(e2, cs.m_u); A(7, 2) = glm::dot(e2, cs.m_v);
+		A(8, 2) = glm::dot(e2, cs.m_u); A(8, 3) = glm::dot(e2, cs.m_v);
+
+		Eigen::MatrixXf b = Eigen::MatrixXf::Zero(9, 1);
+		b(0, 0) = ((sff_v1 - sff_v0) * glm::vec2(cs.m_u)).x;
+		b(1, 0) = ((sff_v1 - sff_v0) * glm::vec2(cs.m_u)).y;
+		b(2, 0) = ((sff_v1 - sff_v0) * glm::vec2(cs.m_v)).y;
+		b(3, 0) = ((sff_v2 - sff_v1) * glm::vec2(cs.m_u)).x;
+		b(4, 0) = ((sff_v2 - sff_v1) * glm::vec2(cs.m_u)).y;
+		b(5, 0) = ((sff_v2 - sff_v1) * glm::vec2(cs.m_v)).y;
+		b(6, 0) = ((sff_v0 - sff_v2) * glm::vec2(cs.m_u)).x;
+		b(7, 0) = ((sff_v0 - sff_v2) * glm::vec2(cs.m_u)).y;
+		b(8, 0) = ((sff_v0 - sff_v2) * glm::vec2(cs.m_v)).y;
+
+		Eigen::Vector4f x = A.colPivHouseholderQr().solve(b);
+		oC[i] = MatCube(x(0), x(1), x(2), x(3));
+	}
+}
+
+// faces per second of the per face Weingarten and C fits on a single thread, before (QR) and after
+// (normal equations), with the largest difference between both results relative to the largest value
+int fit_benchmark(std::string const& iPath, MeshOptions const& iOptions)
+{
+	struct Geometry geom;
+	if (!setup_mesh(iPath, iOptions, MeshStage::Curvatures, geom)) { return -1; }
+
+	ThreadPool single(1);
+	int const runs = 5;
+	auto time_ms = [&](std::function<void()> const& iRun)
+	{
+		iRun(); // warm up
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r) { iRun(); }
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+	};
+	auto report = [&](char const* iName, double iBeforeMs, double iAfterMs, float iDifference)
+	{
+		double faces = static_cast<double>(geom.m_face.size());
+		std::cout << iName << " : " << faces / (iBeforeMs * 1000.0) << " -> " << faces / (iAfterMs * 1000.0) << " Mfaces/s, speedup "
+			<< iBeforeMs / iAfterMs << ", relative difference " << iDifference << std::endl;
+	};
+
+	std::vector<glm::mat2> qr_weingarten;
+	double before_ms = time_ms([&]() { qr_face_weingarten(geom, qr_weingarten); });
+	double after_ms = time_ms([&]() { geom.compute_per_face_weingarten_matrix(single); });
+	float largest = 0.0f;
+	float difference = 0.0f;
+	for (size_t i = 0; i < geom.m_face.size(); ++i)
+	{
+		for (int c = 0; c < 2; ++c)
+		{
+			for (int r = 0; r < 2; ++r)
+			{
+				largest = std::max(largest, std::abs(qr_weingarten[i][c][r]));
+				difference = std::max(difference, std::abs(qr_weingarten[i][c][r] - geom.m_face_weingarten[i][c][r]));
+			}
+		}
+	}
+	report("face weingarten", before_ms, after_ms, difference / largest);
+
+	std::vector<MatCube> qr_C;
+	before_ms = time_ms([&]() { qr_face_C(geom, qr_C); });
+	after_ms = time_ms([&]() { geom.compute_per_face_C(single); });
+	largest = 0.0f;
+	difference = 0.0f;
+	for (size_t i = 0; i < geom.m_face.size(); ++i)
+	{
+		float const before[4] = { qr_C[i].m_a[0][0], qr_C[i].m_a[0][1], qr_C[i].m_a[1][1], qr_C[i].m_b[1][1] };
+		float const after[4] = { geom.m_face_C[i].m_a[0][0], geom.m_face_C[i].m_a[0][1], geom.m_face_C[i].m_a[1][1], geom.m_face_C[i].m_b[1][1] };
+		for (int k = 0; k < 4; ++k)
+		{
+			largest = std::max(largest, std::abs(before[k]));
+			difference = std::max(difference, std::abs(before[k] - after[k]));
+		}
+	}
+	report("face C", before_ms, after_ms, difference / largest);
+	return 0;
+}
+
+// time Geometry::compute_curvatures for 1 to hardware_concurrency threads
+// and check that every thread count gives the single threaded result bit for bit
+int scaling_benchmark(std::string const& iPath, MeshOptions const& iOptions)
+{
+	struct Geometry geom;
+	if (!setup_mesh(iPath, iOptions, MeshStage::Adjacency, geom)) { return -1; }
+
+	struct Geometry reference = geom;
+	ThreadPool single(1);
+	reference.compute_curvatures(single);
+
+	double single_ms = 0.0;
+	unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int threads = 1; threads <= max_threads; ++threads)
+	{
+		ThreadPool pool(threads);
+		geom.compute_curvatures(pool); // warm up
+
+		int const runs = 5;
+		auto start = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+		{
+			geom.compute_curvatures(pool);
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+		if (threads == 1) { single_ms = ms; }
+
+		bool identical = same_bits(geom.m_K1, reference.m_K1) && same_bits(geom.m_K2, reference.m_K2) &&
+			same_bits(geom.m_t1, reference.m_t1) && same_bits(geom.m_t2, reference.m_t2) &&
+			same_bits(geom.m_vertex_C, reference.m_vertex_C);
+		std::cout << threads << " threads : " << ms << " ms, " << geom.m_face.size() / (ms * 1000.0) << " Mfaces/s, speedup "
+			<< single_ms / ms << (identical ? "" : " (RESULTS DIFFER)") << std::endl;
+	}
+	return 0;
+}
+
+// last level cache misses of the calling thread, when the system exposes the hardware counter
+struct CacheMissCounter
+{
+	int m_fd = -1;
+
+	CacheMissCounter()
+	{
+#ifdef __linux__
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		m_fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+	~CacheMissCounter()
+	{
+#ifdef __linux__
+		if (m_fd != -1) { close(m_fd); }
+#endif
+	}
+	bool is_open() const { return m_fd != -1; }
+	void start()
+	{
+#ifdef __linux__
+		if (m_fd == -1) { return; }
+		ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+	}
+	uint64_t stop()
+	{
+		uint64_t count = 0;
+#ifdef __linux__
+		if (m_fd == -1) { return 0; }
+		ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(m_fd, &count, sizeof(count)) != sizeof(count)) { count = 0; }
+#endif
+		return count;
+	}
+};
+
+// time every curvature stage in file order, then in space filling curve order. A single
+// thread runs the stages so that the cache miss counter of the calling thread sees all the work
+int locality_benchmark(std::string const& iPath, MeshOptions const& iOptions)
+{
+	MeshOptions options = iOptions;
+	options.m_reorder = false;
+	struct Geometry file_order;
+	if (!setup_mesh(iPath, options, MeshStage::Loaded, file_order)) { return -1; }
+
+	struct Geometry curve_order = file_order;
+	auto start = std::chrono::steady_clock::now();
+	curve_order.reorder(ThreadPool::global());
+	std::cout << "reorder : " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+	struct Stage
+	{
+		char const* m_name;
+		std::function<void(Geometry&, ThreadPool&)> m_run;
+	};
+	Stage const stages[] =
+	{
+		{ "adjacency", [](Geometry& g, ThreadPool&) { g.compute_adjacency(); } },
+		{ "normals", [](Geometry& g, ThreadPool& p) { g.compute_normals(p); } },
+		{ "face weingarten", [](Geometry& g, ThreadPool& p) { g.compute_per_face_weingarten_matrix(p); } },
+		{ "vertex weingarten", [](Geometry& g, ThreadPool& p) { g.compute_per_vertex_weingarten_matrix(p); } },
+		{ "min max", [](Geometry& g, ThreadPool&) { g.compute_min_max(); } },
+		{ "face C", [](Geometry& g, ThreadPool& p) { g.compute_per_face_C(p); } },
+		{ "vertex C", [](Geometry& g, ThreadPool& p) { g.compute_per_vertex_C(p); } },
+	};
+
+	ThreadPool single(1);
+	CacheMissCounter counter;
+	if (!counter.is_open()) { std::cout << "no hardware cache miss counter, only times are reported" << std::endl; }
+	for (Geometry* geom : { &file_order, &curve_order })
+	{
+		std::cout << (geom == &file_order ? "file order" : "curve order") << " : mean one-ring index distance " << mean_neighbor_distance(geom->m_face) << std::endl;
+		geom->compute_adjacency();
+		geom->compute_curvatures(single); // warm up, sizes the arrays
+
+		double total_ms = 0.0;
+		for (Stage const& stage : stages)
+		{
+			int const runs = 5;
+			uint64_t misses = 0;
+			auto stage_start = std::chrono::steady_clock::now();
+			for (int r = 0; r < runs; ++r)
+			{
+				counter.start();
+				stage.m_run(*geom, single);
+				misses += counter.stop();
+			}
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stage_start).count() / runs;
+			total_ms += ms;
+			std::cout << "  " << stage.m_name << " : " << ms << " ms";
+			if (counter.is_open()) { std::cout << ", " << misses / runs << " cache misses"; }
+			std::cout << std::endl;
+		}
+		std::cout << "  total : " << total_ms << " ms" << std::endl;
+	}
+	return 0;
+}
+
+// average cache miss ratio of the index buffer in load order, then once the faces are in draw order
+int acmr_report(std::string const& iPath, MeshOptions const& iOptions)
+{
+	MeshOptions options = iOptions;
+	options.m_draw_order = false;
+	struct Geometry geom;
+	if (!setup_mesh(iPath, options, MeshStage::Loaded, geom)) { return -1; }
+
+	int const cache_sizes[] = { 8, g_vertexCacheSize, 32 };
+	std::vector<unsigned int> load_order = geom.m_index;
+	DrawOrderReport report;
+	auto start = std::chrono::steady_clock::now();
+	optimize_draw_order(geom.m_vertex, geom.m_face, geom.m_index, report);
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "draw order : " << ms << " ms, " << report.m_clusters << " clusters" << std::endl;
+	for (int cache_size : cache_sizes)
+	{
+		std::cout << "ACMR, FIFO of " << cache_size << " : " << average_cache_miss_ratio(load_order, geom.m_vertex.size(), cache_size)
+			<< " -> " << average_cache_miss_ratio(geom.m_index, geom.m_vertex.size(), cache_size) << std::endl;
+	}
+	return 0;
+}
+
+// time SuggestiveContourExtractor::extract from viewpoints around the mesh for 1 to hardware_concurrency
+// threads and check that every thread count gives the single threaded segments bit for bit
+int contour_benchmark(std::string const& iPath, MeshOptions const& iOptions)
+{
+	struct Geometry geom;
+	if (!setup_mesh(iPath, iOptions, MeshStage::Curvatures, geom)) { return -1; }
+
+	GeometryStreams streams(geom);
+	SuggestiveContourExtractor extractor;
+	auto start = std::chrono::steady_clock::now();
+	extractor.build(ThreadPool::global(), streams.m_streams);
+	std::cout << "build : " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms" << std::endl;
+
+	// 8 viewpoints on a circle 3 bounding radii away, a little above the mesh
+	glm::vec3 center(0.0f);
+	for (glm::vec3 const& v : geom.m_vertex) { center += v; }
+	center /= static_cast<float>(std::max<size_t>(geom.m_vertex.size(), 1));
+	std::vector<glm::vec3> views;
+	for (int k = 0; k < 8; ++k)
+	{
+		float angle = 2.0f * static_cast<float>(M_PI) * k / 8.0f;
+		views.push_back(center + 3.0f * extractor.m_radius * glm::normalize(glm::vec3(std::cos(angle), 0.3f, std::sin(angle))));
+	}
+
+	SuggestiveContourOptions options;
+	std::vector<std::vector<glm::vec3>> reference(views.size());
+	ThreadPool single(1);
+	for (size_t k = 0; k < views.size(); ++k) { extractor.extract(single, views[k], options, reference[k]); }
+	size_t segments = 0;
+	for (std::vector<glm::vec3> const& segment : reference) { segments += segment.size() / 2; }
+	std::cout << segments / views.size() << " segments per view" << std::endl;
+
+	double single_ms = 0.0;
+	std::vector<glm::vec3> segment;
+	unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int threads = 1; threads <= max_threads; ++threads)
+	{
+		ThreadPool pool(threads);
+		bool identical = true;
+		for (size_t k = 0; k < views.size(); ++k)
+		{
+			extractor.extract(pool, views[k], options, segment);
+			identical = identical && same_bits(segment, reference[k]);
+		}
+
+		int const runs = 5;
+		start = std::chrono::steady_clock::now();
+		for (int r = 0; r < runs; ++r)
+		{
+			for (glm::vec3 const& view : views) { extractor.extract(pool, view, options, segment); }
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / (runs * views.size());
+		if (threads == 1) { single_ms = ms; }
+		std::cout << threads << " threads : " << ms << " ms, " << geom.m_face.size() / (ms * 1000.0) << " Mfaces/s, speedup "
+			<< single_ms / ms << (identical ? "" : " (RESULTS DIFFER)") << std::endl;
+	}
+	return 0;
+}
+
+// orbit the camera around the mesh in small steps : time the incremental silhouette extraction against
+// a full pass from the same viewpoint for each family, and check that both give the same segments
+int silhouette_benchmark(std::string const& iPath, MeshOptions const& iOptions)
+{
+	struct Geometry geom;
+	if (!setup_mesh(iPath, iOptions, MeshStage::Curvatures, geom)) { return -1; }
+
+	SilhouetteExtractor incremental;
+	SilhouetteExtractor full;
+	full.build(geom.m_vertex, geom.m_vertex_normal, geom.m_corners);
+
+	// segments as sorted tuples of their ends, the two passes emit them in different orders
+	auto sorted = [](std::vector<glm::vec3> const& iSegment)
+	{
+		std::vector<std::array<float, 6>> segment(iSegment.size() / 2);
+		for (size_t s = 0; s < segment.size(); ++s)
+		{
+			glm::vec3 const& a = iSegment[2 * s];
+			glm::vec3 const& b = iSegment[2 * s + 1];
+			segment[s] = { a.x, a.y, a.z, b.x, b.y, b.z };
+		}
+		std::sort(segment.begin(), segment.end());
+		return segment;
+	};
+
+	// a quarter of a degree per frame, 3 bounding radii away, for every combination of families
+	glm::vec3 center(0.0f);
+	for (glm::vec3 const& v : geom.m_vertex) { center += v; }
+	center /= static_cast<float>(std::max<size_t>(geom.m_vertex.size(), 1));
+	int const frames = 360;
+	struct Families
+	{
+		char const* m_name;
+		int m_families;
+	};
+	Families const families[] = { { "edge and smooth", SF_EDGE | SF_SMOOTH }, { "edge", SF_EDGE }, { "smooth", SF_SMOOTH } };
+	for (Families const& family : families)
+	{
+		incremental.build(geom.m_vertex, geom.m_vertex_normal, geom.m_corners);
+		std::vector<glm::vec3> edge, smooth, full_edge, full_smooth;
+		double incremental_ms = 0.0;
+		double full_ms = 0.0;
+		size_t full_passes = 0;
+		size_t tested_faces = 0;
+		size_t edges = 0;
+		size_t smooth_segments = 0;
+		bool identical = true;
+		for (int k = 0; k < frames; ++k)
+		{
+			float angle = glm::radians(0.25f * k);
+			glm::vec3 view = center + 3.0f * incremental.m_radius * glm::normalize(glm::vec3(std::cos(angle), 0.3f, std::sin(angle)));
+
+			auto start = std::chrono::steady_clock::now();
+			incremental.extract(ThreadPool::global(), view, family.m_families, edge, smooth);
+			incremental_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (incremental.m_tested_faces == geom.m_face.size()) { ++full_passes; }
+			tested_faces += incremental.m_tested_faces;
+
+			full.m_has_view = false;
+			start = std::chrono::steady_clock::now();
+			full.extract(ThreadPool::global(), view, family.m_families, full_edge, full_smooth);
+			full_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			identical = identical && sorted(edge) == sorted(full_edge) && sorted(smooth) == sorted(full_smooth);
+			edges += edge.size() / 2;
+			smooth_segments += smooth.size() / 2;
+		}
+		std::cout << family.m_name << " : " << edges / frames << " silhouette edges and " << smooth_segments / frames << " smooth silhouette segments per frame" << std::endl;
+		std::cout << "  full pass : " << full_ms / frames << " ms" << std::endl;
+		std::cout << "  incremental : " << incremental_ms / frames << " ms, " << full_passes << " full passes in " << frames << " frames, "
+			<< tested_faces / frames << " faces tested per frame" << (identical ? "" : " (RESULTS DIFFER)") << std::endl;
+	}
+	return 0;
+}
+
+struct BenchMode
+{
+	char const* m_name;
+	char const* m_help;
+	int (*m_run)(std::string const& iPath, MeshOptions const& iOptions);
+};
+
+BenchMode const g_benchModes[] =
+{
+	{ "--adjacency", "adjacency build on synthetic grids, compressed against the former quadratic scan", adjacency_benchmark },
+	{ "--check-topology", "corner table queries against scans of the faces", topology_check },
+	{ "--check-taubin", "Taubin smoothing against the dense matrix power filter", taubin_check },
+	{ "--check-taubin-kernel", "Taubin smoothing kernel for 1 to 8 threads against the scalar reference", taubin_kernel_check },
+	{ "--fits", "per face Weingarten and C fits, QR against normal equations", fit_benchmark },
+	{ "--scaling", "curvature pipeline for 1 to hardware_concurrency threads", scaling_benchmark },
+	{ "--locality", "per stage times in file and curve order", locality_benchmark },
+	{ "--acmr", "vertex cache efficiency of the draw order", acmr_report },
+	{ "--contours", "object space suggestive contour extraction", contour_benchmark },
+	{ "--silhouettes", "incremental silhouette extraction", silhouette_benchmark },
+};
+
+int main(int argc, char* argv[])
+{
+	MeshOptions mesh_options;
+	BenchMode const* mode = nullptr;
+	std::string path = "assets/stanford_bunny_high_poly.obj";
+	for (int i = 1; i < argc; ++i)
+	{
+		if (mesh_options.parse(argv[i])) { continue; }
+		BenchMode const* match = std::find_if(std::begin(g_benchModes), std::end(g_benchModes),
+			[&](BenchMode const& iMode) { return std::strcmp(argv[i], iMode.m_name) == 0; });
+		if (match != std::end(g_benchModes)) { mode = match; }
+		else if (argv[i][0] != '-') { path = argv[i]; }
+		else { std::cerr << "WARN: unknown argument " << argv[i] << std::endl; }
+	}
+
+	if (mode == nullptr)
+	{
+		std::cout << "suggestive_contours_bench <mode> [mesh file] [--weld[=tolerance]] [--cull] [--reorder] [--draw-order]" << std::endl;
+		for (BenchMode const& m : g_benchModes) { std::cout << "  " << m.m_name << " : " << m.m_help << std::endl; }
+		return -1;
+	}
+	return mode->m_run(path, mesh_options);
+}
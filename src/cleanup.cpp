@@ -0,0 +1,229 @@
+#include "cleanup.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+	constexpr size_t g_cleanupGrain = 4096;
+	// cell coordinates are packed on 21 bits per axis
+	constexpr int64_t g_cellBits = 21;
+	constexpr int64_t g_maxCell = (int64_t(1) << g_cellBits) - 1;
+
+	uint64_t cell_key(glm::i64vec3 const& iCell)
+	{
+		return (uint64_t(iCell.x) << (2 * g_cellBits)) | (uint64_t(iCell.y) << g_cellBits) | uint64_t(iCell.z);
+	}
+
+	// representative of every vertex : the smallest index within the tolerance,
+	// chains are then followed so that every cluster points to a single vertex
+	void weld_vertices(ThreadPool& iPool, float iTolerance, std::vector<glm::vec3> const& iVertex, std::vector<int>& oRepresentative)
+	{
+		size_t count = iVertex.size();
+		oRepresentative.resize(count);
+		if (count == 0) { return; }
+
+		glm::vec3 min_corner(std::numeric_limits<float>::max());
+		glm::vec3 max_corner(-std::numeric_limits<float>::max());
+		for (glm::vec3 const& v : iVertex)
+		{
+			min_corner = glm::min(min_corner, v);
+			max_corner = glm::max(max_corner, v);
+		}
+
+		// uniform grid of cells much larger than the tolerance : the box of half size
+		// tolerance around a vertex usually fits in its own cell, and overlaps 8 of them at most
+		float diagonal = glm::length(max_corner - min_corner);
+		float tolerance = iTolerance * diagonal;
+		float cell_size = std::max(16.0f * tolerance, diagonal / static_cast<float>(g_maxCell - 1));
+		cell_size = std::max(cell_size, std::numeric_limits<float>::min());
+		auto cell_of = [&](glm::vec3 const& iPosition)
+		{
+			glm::i64vec3 c = glm::i64vec3(glm::floor((iPosition - min_corner) / cell_size));
+			return glm::clamp(c, glm::i64vec3(0), glm::i64vec3(g_maxCell));
+		};
+
+		std::vector<std::pair<uint64_t, int>> sorted(count);
+		iPool.parallel_for(0, count, g_cleanupGrain, [&](size_t iBegin, size_t iEnd)
+		{
+			for (size_t i = iBegin; i < iEnd; ++i)
+			{
+				sorted[i] = { cell_key(cell_of(iVertex[i])), static_cast<int>(i) };
+			}
+		});
+		std::sort(sorted.begin(), sorted.end());
+
+		std::vector<glm::vec3> position(count);
+		iPool.parallel_for(0, count, g_cleanupGrain, [&](size_t iBegin, size_t iEnd)
+		{
+			for (size_t k = iBegin; k < iEnd; ++k)
+			{
+				position[k] = iVertex[sorted[k].second];
+			}
+		});
+
+		// sweep the vertices in cell order : the key of a given neighbor cell only grows,
+		// so every one of the 27 neighbor offsets keeps a cursor that moves forward
+		iPool.parallel_for(0, count, g_cleanupGrain, [&](size_t iBegin, size_t iEnd)
+		{
+			std::array<size_t, 27> cursor;
+			cursor.fill(iBegin);
+			for (size_t k = iBegin; k < iEnd; ++k)
+			{
+				int representative = sorted[k].second;
+				glm::i64vec3 low = cell_of(position[k] - tolerance);
+				glm::i64vec3 high = cell_of(position[k] + tolerance);
+				glm::i64vec3 cell = cell_of(position[k]);
+				for (int64_t x = low.x; x <= high.x; ++x)
+				{
+					for (int64_t y = low.y; y <= high.y; ++y)
+					{
+						for (int64_t z = low.z; z <= high.z; ++z)
+						{
+							glm::i64vec3 offset = glm::i64vec3(x, y, z) - cell + int64_t(1);
+							size_t& it = cursor[offset.x * 9 + offset.y * 3 + offset.z];
+							uint64_t key = cell_key(glm::i64vec3(x, y, z));
+							if (it > 0 && sorted[it - 1].first >= key)
+							{
+								// cursors start at the block, cells that begin before it are found by a search
+								it = std::lower_bound(sorted.begin(), sorted.begin() + it, std::make_pair(key, std::numeric_limits<int>::min())) - sorted.begin();
+							}
+							while (it < count && sorted[it].first < key) { ++it; }
+
+							// vertices of a cell are sorted by index : stop at the first one not below the current best
+							for (size_t j = it; j < count && sorted[j].first == key && sorted[j].second < representative; ++j)
+							{
+								glm::vec3 d = position[j] - position[k];
+								if (glm::dot(d, d) <= tolerance * tolerance)
+								{
+									representative = sorted[j].second;
+									break;
+								}
+							}
+						}
+					}
+				}
+				oRepresentative[sorted[k].second] = representative;
+			}
+		});
+
+		// representatives have smaller indices : resolving them in order flattens every chain
+		for (size_t i = 0; i < count; ++i)
+		{
+			oRepresentative[i] = oRepresentative[oRepresentative[i]];
+		}
+	}
+
+	bool is_degenerate(std::vector<glm::vec3> const& iVertex, glm::ivec3 const& iFace)
+	{
+		if (iFace.x == iFace.y || iFace.y == iFace.z || iFace.z == iFace.x) { return true; }
+
+		// zero area, or so close to it that the normal is noise
+		glm::vec3 e0 = iVertex[iFace.y] - iVertex[iFace.x];
+		glm::vec3 e1 = iVertex[iFace.z] - iVertex[iFace.x];
+		float cross_length = glm::length(glm::cross(e0, e1));
+		return !(cross_length > std::numeric_limits<float>::epsilon() * glm::length(e0) * glm::length(e1));
+	}
+}
+
+void cleanup_mesh(ThreadPool& iPool, CleanupOptions const& iOptions,
+	std::vector<glm::vec3>& ioVertex, std::vector<glm::ivec3>& ioFace, std::vector<unsigned int>& ioIndex, CleanupReport& oReport)
+{
+	oReport = CleanupReport();
+	size_t vertex_count = ioVertex.size();
+	size_t face_count = ioFace.size();
+
+	if (iOptions.m_weld)
+	{
+		std::vector<int> representative;
+		weld_vertices(iPool, iOptions.m_weld_tolerance, ioVertex, representative);
+		for (size_t i = 0; i < vertex_count; ++i)
+		{
+			oReport.m_welded_vertices += (representative[i] != static_cast<int>(i));
+		}
+
+		iPool.parallel_for(0, face_count, g_cleanupGrain, [&](size_t iBegin, size_t iEnd)
+		{
+			for (size_t f = iBegin; f < iEnd; ++f)
+			{
+				glm::ivec3& face = ioFace[f];
+				face = glm::ivec3(representative[face.x], representative[face.y], representative[face.z]);
+			}
+		});
+	}
+
+	// faces to keep
+	std::vector<unsigned char> keep(face_count, 1);
+	if (iOptions.m_cull_faces)
+	{
+		iPool.parallel_for(0, face_count, g_cleanupGrain, [&](size_t iBegin, size_t iEnd)
+		{
+			for (size_t f = iBegin; f < iEnd; ++f)
+			{
+				keep[f] = !is_degenerate(ioVertex, ioFace[f]);
+			}
+		});
+		for (size_t f = 0; f < face_count; ++f)
+		{
+			oReport.m_degenerate_faces += !keep[f];
+		}
+
+		// duplicates : sort the faces by their vertex set, the first face of a set is kept
+		std::vector<std::pair<std::array<int, 3>, int>> sorted;
+		sorted.reserve(face_count);
+		for (size_t f = 0; f < face_count; ++f)
+		{
+			if (!keep[f]) { continue; }
+			std::array<int, 3> vertices = { ioFace[f].x, ioFace[f].y, ioFace[f].z };
+			std::sort(vertices.begin(), vertices.end());
+			sorted.emplace_back(vertices, static_cast<int>(f));
+		}
+		std::sort(sorted.begin(), sorted.end());
+		for (size_t k = 1; k < sorted.size(); ++k)
+		{
+			if (sorted[k].first == sorted[k - 1].first)
+			{
+				keep[sorted[k].second] = 0;
+				++oReport.m_duplicate_faces;
+			}
+		}
+	}
+
+	// compact the faces, then the vertices they still use
+	std::vector<int> new_index(vertex_count, -1);
+	size_t kept_faces = 0;
+	for (size_t f = 0; f < face_count; ++f)
+	{
+		if (!keep[f]) { continue; }
+		ioFace[kept_faces++] = ioFace[f];
+		new_index[ioFace[f].x] = 0;
+		new_index[ioFace[f].y] = 0;
+		new_index[ioFace[f].z] = 0;
+	}
+	ioFace.resize(kept_faces);
+
+	size_t kept_vertices = 0;
+	for (size_t i = 0; i < vertex_count; ++i)
+	{
+		if (new_index[i] < 0) { continue; }
+		new_index[i] = static_cast<int>(kept_vertices);
+		ioVertex[kept_vertices++] = ioVertex[i];
+	}
+	oReport.m_unused_vertices = vertex_count - kept_vertices - oReport.m_welded_vertices;
+	ioVertex.resize(kept_vertices);
+
+	ioIndex.resize(3 * kept_faces);
+	iPool.parallel_for(0, kept_faces, g_cleanupGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t f = iBegin; f < iEnd; ++f)
+		{
+			glm::ivec3& face = ioFace[f];
+			face = glm::ivec3(new_index[face.x], new_index[face.y], new_index[face.z]);
+			ioIndex[3 * f] = face.x;
+			ioIndex[3 * f + 1] = face.y;
+			ioIndex[3 * f + 2] = face.z;
+		}
+	});
+}
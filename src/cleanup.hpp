@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "thread_pool.hpp"
+
+struct CleanupOptions
+{
+	bool m_weld = false;				// merge vertices closer than the tolerance
+	float m_weld_tolerance = 1e-5f;		// relative to the bounding box diagonal
+	bool m_cull_faces = false;			// remove degenerate and duplicate faces
+};
+
+struct CleanupReport
+{
+	size_t m_welded_vertices = 0;		// merged into another vertex
+	size_t m_unused_vertices = 0;		// referenced by no face once the faces are culled
+	size_t m_degenerate_faces = 0;		// repeated vertex or zero area
+	size_t m_duplicate_faces = 0;		// same three vertices as an earlier face, in any order
+};
+
+// welding, then face culling, then removal of the vertices no face uses anymore.
+// Kept vertices and faces stay in their original order and each step only depends
+// on the input, so the result does not depend on the thread count.
+void cleanup_mesh(ThreadPool& iPool, CleanupOptions const& iOptions,
+	std::vector<glm::vec3>& ioVertex, std::vector<glm::ivec3>& ioFace, std::vector<unsigned int>& ioIndex, CleanupReport& oReport);
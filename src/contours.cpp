@@ -0,0 +1,168 @@
+#include "contours.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Dense>
+
+using Lanes = Eigen::Array<float, g_contourLanes, 1>;
+
+namespace
+{
+	constexpr size_t g_contourGrain = 4096;		// a multiple of g_contourLanes
+	constexpr float g_tiny = 1e-20f;
+
+	Lanes load(std::vector<float> const& iArray, size_t i)
+	{
+		return Eigen::Map<Lanes const>(iArray.data() + i);
+	}
+
+	void store(std::vector<float>& oArray, size_t i, Lanes const& iValue)
+	{
+		Eigen::Map<Lanes>(oArray.data() + i) = iValue;
+	}
+
+	// zero crossing of Kn on an edge, with the per vertex values interpolated there
+	struct Crossing
+	{
+		glm::vec3 m_position;
+		float m_DwKn;
+		float m_cos;
+	};
+
+	// keeps the part of [ioBegin, ioEnd] where iA + s iB > 0
+	void clip(float iA, float iB, float& ioBegin, float& ioEnd)
+	{
+		if (iB > 0.0f) { ioBegin = std::max(ioBegin, -iA / iB); }
+		else if (iB < 0.0f) { ioEnd = std::min(ioEnd, -iA / iB); }
+		else if (iA <= 0.0f) { ioEnd = -1.0f; }
+	}
+}
+
+void SuggestiveContourExtractor::build(ThreadPool& iPool, VertexStreams const& iStreams)
+{
+	m_vertex_count = iStreams.m_vertex_count;
+	m_index.assign(iStreams.m_index, iStreams.m_index + iStreams.m_index_count);
+
+	size_t padded = (m_vertex_count + g_contourLanes - 1) / g_contourLanes * g_contourLanes;
+	for (std::vector<float>* channel : { &m_px, &m_py, &m_pz, &m_nx, &m_ny, &m_nz, &m_ux, &m_uy, &m_uz, &m_vx, &m_vy, &m_vz,
+		&m_t1u, &m_t1v, &m_K1, &m_K2, &m_Ca, &m_Cb, &m_Cc, &m_Cd, &m_Kn, &m_DwKn, &m_cos })
+	{
+		channel->assign(padded, 0.0f);
+	}
+
+	iPool.parallel_for(0, m_vertex_count, g_contourGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			glm::vec3 const& p = iStreams.m_position[i];
+			glm::vec3 const& n = iStreams.m_normal[i];
+			glm::vec3 const& u = iStreams.m_tangent_u[i];
+			glm::vec3 const& v = iStreams.m_tangent_v[i];
+			m_px[i] = p.x; m_py[i] = p.y; m_pz[i] = p.z;
+			m_nx[i] = n.x; m_ny[i] = n.y; m_nz[i] = n.z;
+			m_ux[i] = u.x; m_uy[i] = u.y; m_uz[i] = u.z;
+			m_vx[i] = v.x; m_vy[i] = v.y; m_vz[i] = v.z;
+			m_t1u[i] = glm::dot(iStreams.m_t1[i], u);
+			m_t1v[i] = glm::dot(iStreams.m_t1[i], v);
+			m_K1[i] = iStreams.m_K1[i];
+			m_K2[i] = iStreams.m_K2[i];
+			m_Ca[i] = iStreams.m_C1[i][0][0];
+			m_Cb[i] = iStreams.m_C1[i][0][1];
+			m_Cc[i] = iStreams.m_C1[i][1][1];
+			m_Cd[i] = iStreams.m_C2[i][1][1];
+		}
+	});
+
+	// bounding sphere around the centroid, makes the derivative threshold independent of the mesh scale
+	glm::vec3 center(0.0f);
+	for (size_t i = 0; i < m_vertex_count; ++i) { center += iStreams.m_position[i]; }
+	if (m_vertex_count > 0) { center /= static_cast<float>(m_vertex_count); }
+	float radius2 = 0.0f;
+	for (size_t i = 0; i < m_vertex_count; ++i)
+	{
+		glm::vec3 d = iStreams.m_position[i] - center;
+		radius2 = std::max(radius2, glm::dot(d, d));
+	}
+	m_radius = (radius2 > 0.0f) ? std::sqrt(radius2) : 1.0f;
+}
+
+void SuggestiveContourExtractor::extract(ThreadPool& iPool, glm::vec3 const& iViewPosition, SuggestiveContourOptions const& iOptions, std::vector<glm::vec3>& oSegment)
+{
+	oSegment.clear();
+	if (m_vertex_count == 0) { return; }
+
+	// ========== per vertex : Kn = K1 cos^2(phi) + K2 sin^2(phi) and DwKn = C(w, w, w), w being the
+	// unit projection of the view vector on the tangent plane. Padding lanes are zero and give zero.
+	iPool.parallel_for(0, m_Kn.size(), g_contourGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t i = iBegin; i < iEnd; i += g_contourLanes)
+		{
+			Lanes view_x = iViewPosition.x - load(m_px, i);
+			Lanes view_y = iViewPosition.y - load(m_py, i);
+			Lanes view_z = iViewPosition.z - load(m_pz, i);
+			Lanes n_dot_view = load(m_nx, i) * view_x + load(m_ny, i) * view_y + load(m_nz, i) * view_z;
+			Lanes x = load(m_ux, i) * view_x + load(m_uy, i) * view_y + load(m_uz, i) * view_z;
+			Lanes y = load(m_vx, i) * view_x + load(m_vy, i) * view_y + load(m_vz, i) * view_z;
+			Lanes inv_w = (x * x + y * y).max(g_tiny).rsqrt();
+			x *= inv_w;
+			y *= inv_w;
+
+			Lanes cos_phi = x * load(m_t1u, i) + y * load(m_t1v, i);
+			Lanes cos2 = cos_phi * cos_phi;
+			store(m_Kn, i, load(m_K1, i) * cos2 + load(m_K2, i) * (1.0f - cos2));
+			store(m_DwKn, i, x * x * (load(m_Ca, i) * x + 3.0f * load(m_Cb, i) * y) + y * y * (3.0f * load(m_Cc, i) * x + load(m_Cd, i) * y));
+			store(m_cos, i, n_dot_view * (view_x * view_x + view_y * view_y + view_z * view_z).max(g_tiny).rsqrt());
+		}
+	});
+
+	// ========== per face : the segment joining the two edge crossings of Kn, clipped to where
+	// DwKn r^2 > t_d and 0 < cos < cos(theta_c), all three being interpolated linearly along it
+	size_t face_count = m_index.size() / 3;
+	m_block_segment.resize((face_count + g_contourGrain - 1) / g_contourGrain);
+	float min_derivative = iOptions.m_min_derivative / (m_radius * m_radius);
+	float max_cos = std::cos(iOptions.m_min_angle);
+
+	auto crossing = [&](unsigned int i, unsigned int j)
+	{
+		// same order from both faces of the edge
+		if (j < i) { std::swap(i, j); }
+		float t = m_Kn[i] / (m_Kn[i] - m_Kn[j]);
+		Crossing c;
+		c.m_position = glm::vec3(m_px[i] + t * (m_px[j] - m_px[i]), m_py[i] + t * (m_py[j] - m_py[i]), m_pz[i] + t * (m_pz[j] - m_pz[i]));
+		c.m_DwKn = m_DwKn[i] + t * (m_DwKn[j] - m_DwKn[i]);
+		c.m_cos = m_cos[i] + t * (m_cos[j] - m_cos[i]);
+		return c;
+	};
+
+	iPool.parallel_for(0, face_count, g_contourGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		std::vector<glm::vec3>& segment = m_block_segment[iBegin / g_contourGrain];
+		segment.clear();
+		for (size_t f = iBegin; f < iEnd; ++f)
+		{
+			unsigned int const* corner = m_index.data() + 3 * f;
+			bool negative[3] = { m_Kn[corner[0]] < 0.0f, m_Kn[corner[1]] < 0.0f, m_Kn[corner[2]] < 0.0f };
+			if (negative[0] == negative[1] && negative[1] == negative[2]) { continue; }
+
+			// the corner alone on its side of the zero set
+			int a = (negative[0] != negative[1] && negative[0] != negative[2]) ? 0 : (negative[0] == negative[2]) ? 1 : 2;
+			Crossing p = crossing(corner[a], corner[(a + 1) % 3]);
+			Crossing q = crossing(corner[a], corner[(a + 2) % 3]);
+
+			float begin = 0.0f;
+			float end = 1.0f;
+			clip(p.m_DwKn - min_derivative, q.m_DwKn - p.m_DwKn, begin, end);
+			clip(p.m_cos, q.m_cos - p.m_cos, begin, end);
+			clip(max_cos - p.m_cos, p.m_cos - q.m_cos, begin, end);
+			if (end <= begin) { continue; }
+
+			segment.push_back(p.m_position + begin * (q.m_position - p.m_position));
+			segment.push_back(p.m_position + end * (q.m_position - p.m_position));
+		}
+	});
+
+	size_t total = 0;
+	for (std::vector<glm::vec3> const& segment : m_block_segment) { total += segment.size(); }
+	oSegment.reserve(total);
+	for (std::vector<glm::vec3> const& segment : m_block_segment) { oSegment.insert(oSegment.end(), segment.begin(), segment.end()); }
+}
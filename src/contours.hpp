@@ -0,0 +1,48 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "thread_pool.hpp"
+#include "curvature_cache.hpp"
+
+// vertices processed together by the radial curvature kernel
+constexpr int g_contourLanes = 8;
+
+// trimming of the zero crossings of the radial curvature, DeCarlo et al. 2003 (5) and (7)
+struct SuggestiveContourOptions
+{
+	float m_min_derivative = 0.0f;		// t_d : minimum of DwKn r^2, r being the bounding radius of the mesh
+	float m_min_angle = 0.0f;			// theta_c : minimum angle in radians between the normal and the view vector
+};
+
+// object space suggestive contours : the zero crossings of the radial curvature Kn on the
+// front faces where its derivative DwKn along the projected view vector w is positive.
+// The vertex data is copied once by build, extract only depends on the viewpoint.
+// Segments come out in face order whatever the thread count, and the crossing on an edge
+// is computed the same way from both of its faces so that the segments form chains.
+struct SuggestiveContourExtractor
+{
+	void build(ThreadPool& iPool, VertexStreams const& iStreams);
+	// pairs of segment ends in object space, iViewPosition is the camera in object space
+	void extract(ThreadPool& iPool, glm::vec3 const& iViewPosition, SuggestiveContourOptions const& iOptions, std::vector<glm::vec3>& oSegment);
+
+	size_t m_vertex_count = 0;
+	float m_radius = 1.0f;
+	std::vector<unsigned int> m_index;
+
+	// per vertex, padded to a multiple of g_contourLanes
+	std::vector<float> m_px, m_py, m_pz;
+	std::vector<float> m_nx, m_ny, m_nz;
+	std::vector<float> m_ux, m_uy, m_uz;
+	std::vector<float> m_vx, m_vy, m_vz;
+	std::vector<float> m_t1u, m_t1v;		// T1 in the (U, V) frame
+	std::vector<float> m_K1, m_K2;
+	std::vector<float> m_Ca, m_Cb, m_Cc, m_Cd;	// C1 = [[a, b], [b, c]], C2 = [[b, c], [c, d]]
+
+	// per vertex and per view
+	std::vector<float> m_Kn;
+	std::vector<float> m_DwKn;
+	std::vector<float> m_cos;			// n.v / |v|
+
+	std::vector<std::vector<glm::vec3>> m_block_segment;
+};
@@ -0,0 +1,178 @@
+#include "curvature_cache.hpp"
+#include "vertex_format.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	struct CacheHeader
+	{
+		char m_magic[8];
+		uint32_t m_version;
+		uint32_t m_byte_order;
+		uint64_t m_source_hash;
+		uint64_t m_source_size;
+		uint64_t m_vertex_count;
+		uint64_t m_index_count;
+	};
+
+	constexpr char g_cacheMagic[8] = { 'S', 'C', 'C', 'U', 'R', 'V', '\0', '\0' };
+	constexpr uint32_t g_byteOrderMark = 0x01020304;
+	constexpr size_t g_streamAlignment = 16;
+	constexpr size_t g_streamCount = 12;
+
+	size_t align(size_t iOffset)
+	{
+		return (iOffset + g_streamAlignment - 1) / g_streamAlignment * g_streamAlignment;
+	}
+
+	// byte size of every stream, in file order
+	std::array<size_t, g_streamCount> stream_sizes(size_t iVertexCount, size_t iIndexCount)
+	{
+		size_t vec3 = iVertexCount * sizeof(glm::vec3);
+		size_t scalar = iVertexCount * sizeof(float);
+		size_t mat2 = iVertexCount * sizeof(glm::mat2);
+		return { vec3, vec3, vec3, vec3, scalar, scalar, vec3, vec3, mat2, mat2, iVertexCount * sizeof(PackedVertex), iIndexCount * sizeof(unsigned int) };
+	}
+
+	std::array<void const*, g_streamCount> stream_pointers(VertexStreams const& iStreams)
+	{
+		return { iStreams.m_position, iStreams.m_normal, iStreams.m_tangent_u, iStreams.m_tangent_v,
+			iStreams.m_K1, iStreams.m_K2, iStreams.m_t1, iStreams.m_t2, iStreams.m_C1, iStreams.m_C2, iStreams.m_packed, iStreams.m_index };
+	}
+}
+
+uint64_t hash_bytes(unsigned char const* iData, size_t iSize)
+{
+	uint64_t const prime = 0x100000001b3ull;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= iSize; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		std::memcpy(&word, iData + i, sizeof(uint64_t));
+		hash = (hash ^ word) * prime;
+	}
+	for (; i < iSize; ++i)
+	{
+		hash = (hash ^ iData[i]) * prime;
+	}
+	return hash;
+}
+
+std::string CurvatureCache::path_for(std::string const& iSourcePath)
+{
+	return iSourcePath + ".curv";
+}
+
+bool CurvatureCache::open(std::string const& iCachePath, uint64_t iSourceHash, uint64_t iSourceSize)
+{
+	if (!m_file.open(iCachePath) || m_file.size() < sizeof(CacheHeader)) { return false; }
+
+	CacheHeader header;
+	std::memcpy(&header, m_file.data(), sizeof(CacheHeader));
+	if (std::memcmp(header.m_magic, g_cacheMagic, sizeof(g_cacheMagic)) != 0 ||
+		header.m_version != g_curvatureCacheVersion ||
+		header.m_byte_order != g_byteOrderMark ||
+		header.m_source_hash != iSourceHash ||
+		header.m_source_size != iSourceSize)
+	{
+		m_file.close();
+		return false;
+	}
+
+	// every vertex and index takes more than a byte of the file, which also keeps the sizes from overflowing
+	if (header.m_vertex_count > m_file.size() / sizeof(PackedVertex) || header.m_index_count > m_file.size() / sizeof(unsigned int))
+	{
+		m_file.close();
+		return false;
+	}
+
+	std::array<size_t, g_streamCount> sizes = stream_sizes(header.m_vertex_count, header.m_index_count);
+	std::array<unsigned char const*, g_streamCount> pointers;
+	size_t offset = align(sizeof(CacheHeader));
+	for (size_t s = 0; s < g_streamCount; ++s)
+	{
+		pointers[s] = m_file.data() + offset;
+		offset = align(offset + sizes[s]);
+	}
+	if (offset != m_file.size())
+	{
+		m_file.close();
+		return false;
+	}
+
+	// a corrupt index stream must not reach the adjacency or the GPU
+	unsigned int const* index = reinterpret_cast<unsigned int const*>(pointers[11]);
+	unsigned int max_index = 0;
+	for (size_t i = 0; i < header.m_index_count; ++i) { max_index = std::max(max_index, index[i]); }
+	if (header.m_vertex_count == 0 || header.m_index_count == 0 || header.m_index_count % 3 != 0 || max_index >= header.m_vertex_count)
+	{
+		m_file.close();
+		return false;
+	}
+
+	m_streams.m_vertex_count = header.m_vertex_count;
+	m_streams.m_index_count = header.m_index_count;
+	m_streams.m_position = reinterpret_cast<glm::vec3 const*>(pointers[0]);
+	m_streams.m_normal = reinterpret_cast<glm::vec3 const*>(pointers[1]);
+	m_streams.m_tangent_u = reinterpret_cast<glm::vec3 const*>(pointers[2]);
+	m_streams.m_tangent_v = reinterpret_cast<glm::vec3 const*>(pointers[3]);
+	m_streams.m_K1 = reinterpret_cast<float const*>(pointers[4]);
+	m_streams.m_K2 = reinterpret_cast<float const*>(pointers[5]);
+	m_streams.m_t1 = reinterpret_cast<glm::vec3 const*>(pointers[6]);
+	m_streams.m_t2 = reinterpret_cast<glm::vec3 const*>(pointers[7]);
+	m_streams.m_C1 = reinterpret_cast<glm::mat2 const*>(pointers[8]);
+	m_streams.m_C2 = reinterpret_cast<glm::mat2 const*>(pointers[9]);
+	m_streams.m_packed = reinterpret_cast<PackedVertex const*>(pointers[10]);
+	m_streams.m_index = reinterpret_cast<unsigned int const*>(pointers[11]);
+	return true;
+}
+
+bool CurvatureCache::write(std::string const& iCachePath, uint64_t iSourceHash, uint64_t iSourceSize, VertexStreams const& iStreams)
+{
+	CacheHeader header;
+	std::memcpy(header.m_magic, g_cacheMagic, sizeof(g_cacheMagic));
+	header.m_version = g_curvatureCacheVersion;
+	header.m_byte_order = g_byteOrderMark;
+	header.m_source_hash = iSourceHash;
+	header.m_source_size = iSourceSize;
+	header.m_vertex_count = iStreams.m_vertex_count;
+	header.m_index_count = iStreams.m_index_count;
+
+	std::string temporary_path = iCachePath + ".tmp";
+	bool written = false;
+	{
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		if (!file) { return false; }
+
+		char const padding[g_streamAlignment] = {};
+		file.write(reinterpret_cast<char const*>(&header), sizeof(CacheHeader));
+		size_t offset = sizeof(CacheHeader);
+
+		std::array<size_t, g_streamCount> sizes = stream_sizes(iStreams.m_vertex_count, iStreams.m_index_count);
+		std::array<void const*, g_streamCount> pointers = stream_pointers(iStreams);
+		for (size_t s = 0; s < g_streamCount; ++s)
+		{
+			file.write(padding, align(offset) - offset);
+			offset = align(offset);
+			file.write(static_cast<char const*>(pointers[s]), sizes[s]);
+			offset += sizes[s];
+		}
+		file.write(padding, align(offset) - offset);
+		file.flush();
+		written = static_cast<bool>(file);
+	}
+
+	if (!written)
+	{
+		std::remove(temporary_path.c_str());
+		return false;
+	}
+	std::remove(iCachePath.c_str());
+	return std::rename(temporary_path.c_str(), iCachePath.c_str()) == 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+#include "mapped_file.hpp"
+
+// bump whenever the layout or the meaning of a stream changes
+constexpr uint32_t g_curvatureCacheVersion = 2;
+
+struct PackedVertex;
+
+// per vertex arrays read by the CPU passes, the interleaved VBO vertices and the triangle indices
+struct VertexStreams
+{
+	size_t m_vertex_count = 0;
+	size_t m_index_count = 0;
+	glm::vec3 const* m_position = nullptr;
+	glm::vec3 const* m_normal = nullptr;
+	glm::vec3 const* m_tangent_u = nullptr;
+	glm::vec3 const* m_tangent_v = nullptr;
+	float const* m_K1 = nullptr;
+	float const* m_K2 = nullptr;
+	glm::vec3 const* m_t1 = nullptr;
+	glm::vec3 const* m_t2 = nullptr;
+	glm::mat2 const* m_C1 = nullptr;
+	glm::mat2 const* m_C2 = nullptr;
+	PackedVertex const* m_packed = nullptr;		// uploaded as is, packed from the streams above when null
+	unsigned int const* m_index = nullptr;
+};
+
+// 64 bit FNV-1a over 8 byte words, the tail bytes one by one
+uint64_t hash_bytes(unsigned char const* iData, size_t iSize);
+
+// curvature data of a mesh stored next to its source file (<source>.curv).
+// The file is a header followed by the streams, each one 16 bytes aligned,
+// and is only valid for the source file whose size and hash it records.
+// The PackedVertex stream goes to the VBO without being packed again.
+struct CurvatureCache
+{
+	static std::string path_for(std::string const& iSourcePath);
+
+	// map the cache and check it against the source file, false when missing or stale
+	bool open(std::string const& iCachePath, uint64_t iSourceHash, uint64_t iSourceSize);
+	VertexStreams const& streams() const { return m_streams; }
+
+	// write to a temporary file then rename it, a reader never sees a partial cache.
+	// iStreams.m_packed must be set.
+	static bool write(std::string const& iCachePath, uint64_t iSourceHash, uint64_t iSourceSize, VertexStreams const& iStreams);
+
+	MappedFile m_file;
+	VertexStreams m_streams;
+};
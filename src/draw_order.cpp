@@ -0,0 +1,184 @@
+#include "draw_order.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace
+{
+	struct Cluster
+	{
+		size_t m_begin;
+		size_t m_end;
+		float m_occlusion;			// how much the cluster faces away from the mesh center
+	};
+}
+
+void optimize_draw_order(std::vector<glm::vec3> const& iVertex, std::vector<glm::ivec3>& ioFace, std::vector<unsigned int>& ioIndex, DrawOrderReport& oReport, int iCacheSize)
+{
+	oReport = DrawOrderReport();
+	size_t vertex_count = iVertex.size();
+	size_t face_count = ioFace.size();
+	if (face_count == 0) { return; }
+
+	// faces of every vertex
+	std::vector<int> offset(vertex_count + 1, 0);
+	for (glm::ivec3 const& face : ioFace)
+	{
+		for (int c = 0; c < 3; ++c) { ++offset[face[c] + 1]; }
+	}
+	std::partial_sum(offset.begin(), offset.end(), offset.begin());
+	std::vector<int> vertex_faces(3 * face_count);
+	std::vector<int> next_slot(offset.begin(), offset.end() - 1);
+	for (size_t f = 0; f < face_count; ++f)
+	{
+		for (int c = 0; c < 3; ++c) { vertex_faces[next_slot[ioFace[f][c]]++] = static_cast<int>(f); }
+	}
+
+	// ========== Tipsify : fan the faces of a vertex, then move to a vertex of those faces still in the cache
+	std::vector<int> live(vertex_count);				// faces of the vertex not emitted yet
+	for (size_t v = 0; v < vertex_count; ++v) { live[v] = offset[v + 1] - offset[v]; }
+	std::vector<int> cache_time(vertex_count, 0);		// time stamp of the vertex when it entered the cache
+	std::vector<unsigned char> emitted(face_count, 0);
+	std::vector<int> dead_end;							// recently used vertices, to restart from when a fan ends nowhere
+	std::vector<int> candidates;
+	std::vector<int> order;
+	std::vector<size_t> cluster_end;
+	order.reserve(face_count);
+	int time = iCacheSize + 1;
+	size_t cursor = 0;
+
+	auto skip_dead_end = [&]()
+	{
+		while (!dead_end.empty())
+		{
+			int v = dead_end.back();
+			dead_end.pop_back();
+			if (live[v] > 0) { return v; }
+		}
+		for (; cursor < vertex_count; ++cursor)
+		{
+			if (live[cursor] > 0) { return static_cast<int>(cursor); }
+		}
+		return -1;
+	};
+
+	int fanning = skip_dead_end();
+	while (fanning >= 0)
+	{
+		candidates.clear();
+		for (int k = offset[fanning]; k < offset[fanning + 1]; ++k)
+		{
+			int f = vertex_faces[k];
+			if (emitted[f]) { continue; }
+			emitted[f] = 1;
+			order.push_back(f);
+			for (int c = 0; c < 3; ++c)
+			{
+				int v = ioFace[f][c];
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+				if (time - cache_time[v] > iCacheSize)
+				{
+					cache_time[v] = time;
+					++time;
+				}
+			}
+		}
+
+		// the candidate that entered the cache first among those whose remaining faces
+		// will still find it there, or any candidate with remaining faces
+		int next = -1;
+		int best_priority = -1;
+		for (int v : candidates)
+		{
+			if (live[v] == 0) { continue; }
+			int priority = 0;
+			if (time - cache_time[v] + 2 * live[v] <= iCacheSize) { priority = time - cache_time[v]; }
+			if (priority > best_priority)
+			{
+				best_priority = priority;
+				next = v;
+			}
+		}
+		// a dead end flushes the cache : the faces drawn so far form a cluster
+		if (next == -1)
+		{
+			cluster_end.push_back(order.size());
+			next = skip_dead_end();
+		}
+		fanning = next;
+	}
+
+	// ========== overdraw : clusters facing away from the mesh center tend to hide the others, draw them first
+	std::vector<Cluster> clusters;
+	size_t begin = 0;
+	for (size_t end : cluster_end)
+	{
+		if (end > begin) { clusters.push_back({ begin, end, 0.0f }); }
+		begin = end;
+	}
+
+	std::vector<glm::vec3> cluster_center(clusters.size());
+	std::vector<glm::vec3> cluster_normal(clusters.size());
+	glm::vec3 mesh_center(0.0f);
+	float mesh_area = 0.0f;
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		// area weighted centroid and normal
+		glm::vec3 center(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (size_t k = clusters[c].m_begin; k < clusters[c].m_end; ++k)
+		{
+			glm::ivec3 const& face = ioFace[order[k]];
+			glm::vec3 area_normal = 0.5f * glm::cross(iVertex[face.y] - iVertex[face.x], iVertex[face.z] - iVertex[face.x]);
+			float face_area = glm::length(area_normal);
+			center += face_area * (iVertex[face.x] + iVertex[face.y] + iVertex[face.z]) / 3.0f;
+			normal += area_normal;
+			area += face_area;
+		}
+		mesh_center += center;
+		mesh_area += area;
+		cluster_center[c] = (area > 0.0f) ? center / area : iVertex[ioFace[order[clusters[c].m_begin]].x];
+		cluster_normal[c] = (glm::length(normal) > 0.0f) ? glm::normalize(normal) : glm::vec3(0.0f);
+	}
+	if (mesh_area > 0.0f) { mesh_center /= mesh_area; }
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		clusters[c].m_occlusion = glm::dot(cluster_center[c] - mesh_center, cluster_normal[c]);
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](Cluster const& a, Cluster const& b) { return a.m_occlusion > b.m_occlusion; });
+	oReport.m_clusters = clusters.size();
+
+	std::vector<glm::ivec3> face;
+	face.reserve(face_count);
+	for (Cluster const& cluster : clusters)
+	{
+		for (size_t k = cluster.m_begin; k < cluster.m_end; ++k) { face.push_back(ioFace[order[k]]); }
+	}
+	ioFace.swap(face);
+
+	ioIndex.resize(3 * face_count);
+	for (size_t f = 0; f < face_count; ++f)
+	{
+		ioIndex[3 * f] = ioFace[f].x;
+		ioIndex[3 * f + 1] = ioFace[f].y;
+		ioIndex[3 * f + 2] = ioFace[f].z;
+	}
+}
+
+double average_cache_miss_ratio(std::vector<unsigned int> const& iIndex, size_t iVertexCount, int iCacheSize)
+{
+	if (iIndex.size() < 3) { return 0.0; }
+
+	// FIFO : a vertex leaves the cache once iCacheSize other vertices entered it
+	std::vector<size_t> entered(iVertexCount, 0);		// miss count once the vertex entered the cache, 0 when never
+	size_t misses = 0;
+	for (unsigned int v : iIndex)
+	{
+		if (entered[v] != 0 && misses - entered[v] < static_cast<size_t>(iCacheSize)) { continue; }
+		entered[v] = ++misses;
+	}
+	return static_cast<double>(misses) / static_cast<double>(iIndex.size() / 3);
+}
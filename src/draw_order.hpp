@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// FIFO post-transform cache size the face order is tuned for
+constexpr int g_vertexCacheSize = 16;
+
+struct DrawOrderReport
+{
+	size_t m_clusters = 0;		// runs of faces drawn without a cache flush
+};
+
+// faces reordered for the post-transform vertex cache (Tipsify), then whole clusters sorted
+// so that the ones facing away from the mesh center come first and hide what is behind them.
+// Vertices and the corners of every face are left untouched : only the face order changes.
+void optimize_draw_order(std::vector<glm::vec3> const& iVertex, std::vector<glm::ivec3>& ioFace, std::vector<unsigned int>& ioIndex, DrawOrderReport& oReport, int iCacheSize = g_vertexCacheSize);
+
+// average cache miss ratio : transformed vertices per triangle with a FIFO cache of iCacheSize entries,
+// from 3 with no reuse down to about 0.5 for a regular mesh
+double average_cache_miss_ratio(std::vector<unsigned int> const& iIndex, size_t iVertexCount, int iCacheSize = g_vertexCacheSize);
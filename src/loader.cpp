@@ -0,0 +1,777 @@
+#include "loader.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+	// chunks of roughly this size, at least one per thread
+	constexpr size_t g_objChunkSize = 1 << 20;
+
+	struct ObjChunk
+	{
+		char const* m_begin;
+		char const* m_end;
+		size_t m_vertex_count = 0;
+		size_t m_triangle_count = 0;
+		size_t m_vertex_offset = 0;
+		size_t m_triangle_offset = 0;
+		bool m_valid = true;
+	};
+
+	inline bool is_blank(char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	inline bool is_line_end(char c)
+	{
+		return c == '\n' || c == '\r' || c == '#';
+	}
+
+	inline char const* skip_blanks(char const* p, char const* end)
+	{
+		while (p < end && is_blank(*p)) { ++p; }
+		return p;
+	}
+
+	inline char const* skip_token(char const* p, char const* end)
+	{
+		while (p < end && !is_blank(*p) && !is_line_end(*p)) { ++p; }
+		return p;
+	}
+
+	inline char const* next_line(char const* p, char const* end)
+	{
+		void const* eol = std::memchr(p, '\n', end - p);
+		return eol ? static_cast<char const*>(eol) + 1 : end;
+	}
+
+	// 'v' and 'f' records, "vn", "vt" and anything else is skipped
+	inline char record_type(char const* p, char const* end)
+	{
+		if (p + 1 < end && (*p == 'v' || *p == 'f') && is_blank(p[1])) { return *p; }
+		return '\0';
+	}
+
+	char const* count_face_corners(char const* p, char const* end, int& oCorners)
+	{
+		oCorners = 0;
+		for (p = skip_blanks(p, end); p < end && !is_line_end(*p); p = skip_blanks(p, end))
+		{
+			p = skip_token(p, end);
+			++oCorners;
+		}
+		return p;
+	}
+
+	void count_chunk(ObjChunk& ioChunk)
+	{
+		char const* end = ioChunk.m_end;
+		// p walks the records and stops anywhere before the end of line, next_line resumes from there
+		for (char const* p = ioChunk.m_begin; p < end; p = next_line(p, end))
+		{
+			p = skip_blanks(p, end);
+			char type = record_type(p, end);
+			if (type == 'v')
+			{
+				++ioChunk.m_vertex_count;
+			}
+			else if (type == 'f')
+			{
+				int corners;
+				p = count_face_corners(p + 1, end, corners);
+				ioChunk.m_triangle_count += (corners >= 3) ? corners - 2 : 0;
+			}
+		}
+	}
+
+	// decimal [-]digits[.digits][(e|E)[+-]digits] with at most 15 significant digits and a power
+	// of ten within 1e22 : the product or quotient is correctly rounded in double (Clinger's fast path).
+	// Float midpoints are doubles, so narrowing that double to float gives the correctly rounded float,
+	// like std::from_chars, unless the double is itself a midpoint : that case and anything else goes
+	// through std::from_chars.
+	inline char const* parse_float(char const* p, char const* end, float& oValue, bool& ioValid)
+	{
+		static double const powers_of_ten[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+		p = skip_blanks(p, end);
+		if (p < end && *p == '+') { ++p; }
+		char const* start = p;
+
+		bool negative = (p < end && *p == '-');
+		if (negative) { ++p; }
+
+		uint64_t mantissa = 0;
+		int significant_digits = 0;
+		int exponent = 0;
+		char const* digits_begin = p;
+		for (; p < end && unsigned(*p - '0') < 10; ++p)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			significant_digits += (mantissa != 0);
+		}
+		size_t digit_count = p - digits_begin;
+		if (p < end && *p == '.')
+		{
+			char const* fraction_begin = ++p;
+			for (; p < end && unsigned(*p - '0') < 10; ++p)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				significant_digits += (mantissa != 0);
+			}
+			exponent = -static_cast<int>(p - fraction_begin);
+			digit_count += p - fraction_begin;
+		}
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			char const* q = p + 1;
+			bool negative_exponent = (q < end && *q == '-');
+			if (q < end && (*q == '-' || *q == '+')) { ++q; }
+			int value = 0;
+			char const* exponent_begin = q;
+			for (; q < end && unsigned(*q - '0') < 10 && value < 10000; ++q) { value = value * 10 + (*q - '0'); }
+			if (q != exponent_begin)
+			{
+				exponent += negative_exponent ? -value : value;
+				p = q;
+			}
+		}
+
+		if (digit_count > 0 && significant_digits <= 15 && exponent >= -22 && exponent <= 22)
+		{
+			double value = static_cast<double>(mantissa);
+			value = (exponent < 0) ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+			// the values reached here are normal floats, whose midpoints have the low 29 bits of a double set to 1 << 28
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(double));
+			if ((bits & 0x1FFFFFFFull) != 0x10000000ull)
+			{
+				oValue = static_cast<float>(negative ? -value : value);
+				return p;
+			}
+		}
+
+		std::from_chars_result result = std::from_chars(start, end, oValue);
+		if (result.ec != std::errc()) { ioValid = false; }
+		return result.ptr;
+	}
+
+	void fill_chunk(ObjChunk& ioChunk, size_t iTotalVertexCount,
+		std::vector<glm::vec3>& oVertex, std::vector<glm::ivec3>& oFace, std::vector<unsigned int>& oIndex)
+	{
+		char const* end = ioChunk.m_end;
+		size_t vertex = ioChunk.m_vertex_offset;
+		size_t triangle = ioChunk.m_triangle_offset;
+		for (char const* p = ioChunk.m_begin; p < end; p = next_line(p, end))
+		{
+			p = skip_blanks(p, end);
+			char type = record_type(p, end);
+			if (type == 'v')
+			{
+				glm::vec3& v = oVertex[vertex++];
+				p = parse_float(p + 1, end, v.x, ioChunk.m_valid);
+				p = parse_float(p, end, v.y, ioChunk.m_valid);
+				p = parse_float(p, end, v.z, ioChunk.m_valid);
+			}
+			else if (type == 'f')
+			{
+				// corners are "v", "v/vt", "v//vn" or "v/vt/vn", only v is kept
+				int first = -1;
+				int previous = -1;
+				int corner = 0;
+				for (p = skip_blanks(p + 1, end); p < end && !is_line_end(*p); p = skip_blanks(p, end), ++corner)
+				{
+					long long index = 0;
+					std::from_chars_result result = std::from_chars(p, end, index);
+					if (result.ec != std::errc() || index == 0) { ioChunk.m_valid = false; }
+					index = (index < 0) ? static_cast<long long>(vertex) + index : index - 1;
+					if (index < 0 || index >= static_cast<long long>(iTotalVertexCount)) { ioChunk.m_valid = false; index = 0; }
+					p = skip_token(p, end);
+
+					int current = static_cast<int>(index);
+					if (corner == 0) { first = current; }
+					if (corner >= 2)
+					{
+						oFace[triangle] = glm::ivec3(first, previous, current);
+						oIndex[3 * triangle] = first;
+						oIndex[3 * triangle + 1] = previous;
+						oIndex[3 * triangle + 2] = current;
+						++triangle;
+					}
+					previous = current;
+				}
+			}
+		}
+	}
+}
+
+bool parse_obj(MappedFile const& iFile, ThreadPool& iPool,
+	std::vector<glm::vec3>& oVertex, std::vector<glm::ivec3>& oFace, std::vector<unsigned int>& oIndex, std::string& oError)
+{
+	char const* begin = reinterpret_cast<char const*>(iFile.data());
+	char const* end = begin + iFile.size();
+
+	// line aligned chunks
+	size_t chunk_count = std::max<size_t>(iPool.size(), iFile.size() / g_objChunkSize);
+	std::vector<ObjChunk> chunks;
+	chunks.reserve(chunk_count);
+	char const* chunk_begin = begin;
+	for (size_t c = 1; c <= chunk_count && chunk_begin < end; ++c)
+	{
+		char const* chunk_end = (c == chunk_count) ? end : next_line(begin + iFile.size() * c / chunk_count, end);
+		chunk_end = std::max(chunk_end, chunk_begin);
+		if (chunk_end == chunk_begin) { continue; }
+		chunks.push_back(ObjChunk{ chunk_begin, chunk_end });
+		chunk_begin = chunk_end;
+	}
+
+	// count records, then give every chunk its place in the output arrays
+	iPool.parallel_for(0, chunks.size(), 1, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t c = iBegin; c < iEnd; ++c) { count_chunk(chunks[c]); }
+	});
+
+	size_t vertex_count = 0;
+	size_t triangle_count = 0;
+	for (ObjChunk& chunk : chunks)
+	{
+		chunk.m_vertex_offset = vertex_count;
+		chunk.m_triangle_offset = triangle_count;
+		vertex_count += chunk.m_vertex_count;
+		triangle_count += chunk.m_triangle_count;
+	}
+
+	oVertex.resize(vertex_count);
+	oFace.resize(triangle_count);
+	oIndex.resize(3 * triangle_count);
+
+	iPool.parallel_for(0, chunks.size(), 1, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t c = iBegin; c < iEnd; ++c) { fill_chunk(chunks[c], vertex_count, oVertex, oFace, oIndex); }
+	});
+
+	for (ObjChunk const& chunk : chunks)
+	{
+		if (!chunk.m_valid)
+		{
+			oError = "malformed vertex or face record near byte " + std::to_string(chunk.m_begin - begin);
+			return false;
+		}
+	}
+	if (triangle_count == 0)
+	{
+		oError = "no triangle";
+		return false;
+	}
+	return true;
+}
+
+namespace
+{
+	enum class PlyType
+	{
+		INT8, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64
+	};
+
+	struct PlyProperty
+	{
+		std::string m_name;
+		PlyType m_type;
+		bool m_is_list = false;
+		PlyType m_count_type = PlyType::UINT8;
+	};
+
+	struct PlyElement
+	{
+		std::string m_name;
+		size_t m_count = 0;
+		std::vector<PlyProperty> m_properties;
+	};
+
+	bool ply_type(std::string const& iName, PlyType& oType)
+	{
+		static std::pair<char const*, PlyType> const names[] = {
+			{ "char", PlyType::INT8 }, { "int8", PlyType::INT8 },
+			{ "uchar", PlyType::UINT8 }, { "uint8", PlyType::UINT8 },
+			{ "short", PlyType::INT16 }, { "int16", PlyType::INT16 },
+			{ "ushort", PlyType::UINT16 }, { "uint16", PlyType::UINT16 },
+			{ "int", PlyType::INT32 }, { "int32", PlyType::INT32 },
+			{ "uint", PlyType::UINT32 }, { "uint32", PlyType::UINT32 },
+			{ "float", PlyType::FLOAT32 }, { "float32", PlyType::FLOAT32 },
+			{ "double", PlyType::FLOAT64 }, { "float64", PlyType::FLOAT64 } };
+		for (auto const& name : names)
+		{
+			if (iName == name.first)
+			{
+				oType = name.second;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	size_t ply_type_size(PlyType iType)
+	{
+		switch (iType)
+		{
+		case PlyType::INT8: case PlyType::UINT8: return 1;
+		case PlyType::INT16: case PlyType::UINT16: return 2;
+		case PlyType::INT32: case PlyType::UINT32: case PlyType::FLOAT32: return 4;
+		default: return 8;
+		}
+	}
+
+	// bytes of the shortest record of an element, its lists being empty
+	size_t ply_min_record_size(PlyElement const& iElement)
+	{
+		size_t size = 0;
+		for (PlyProperty const& property : iElement.m_properties)
+		{
+			size += ply_type_size(property.m_is_list ? property.m_count_type : property.m_type);
+		}
+		return size;
+	}
+
+	bool host_is_little_endian()
+	{
+		uint16_t const one = 1;
+		unsigned char first;
+		std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	// bounds checked reads of the mapped bytes, swapping them when the file endianness differs
+	struct ByteReader
+	{
+		unsigned char const* m_pos;
+		unsigned char const* m_end;
+		bool m_swap;
+		bool m_valid = true;
+
+		template<typename T>
+		T read()
+		{
+			T value = T();
+			if (static_cast<size_t>(m_end - m_pos) < sizeof(T))
+			{
+				m_valid = false;
+				m_pos = m_end;
+				return value;
+			}
+			unsigned char bytes[sizeof(T)];
+			std::memcpy(bytes, m_pos, sizeof(T));
+			if (m_swap) { std::reverse(bytes, bytes + sizeof(T)); }
+			std::memcpy(&value, bytes, sizeof(T));
+			m_pos += sizeof(T);
+			return value;
+		}
+
+		double read_value(PlyType iType)
+		{
+			switch (iType)
+			{
+			case PlyType::INT8: return read<int8_t>();
+			case PlyType::UINT8: return read<uint8_t>();
+			case PlyType::INT16: return read<int16_t>();
+			case PlyType::UINT16: return read<uint16_t>();
+			case PlyType::INT32: return read<int32_t>();
+			case PlyType::UINT32: return read<uint32_t>();
+			case PlyType::FLOAT32: return read<float>();
+			default: return read<double>();
+			}
+		}
+
+		int64_t read_integer(PlyType iType)
+		{
+			return static_cast<int64_t>(read_value(iType));
+		}
+
+		void skip(size_t iBytes)
+		{
+			if (static_cast<size_t>(m_end - m_pos) < iBytes)
+			{
+				m_valid = false;
+				m_pos = m_end;
+				return;
+			}
+			m_pos += iBytes;
+		}
+
+		void skip_property(PlyProperty const& iProperty)
+		{
+			if (iProperty.m_is_list)
+			{
+				int64_t count = read_integer(iProperty.m_count_type);
+				if (count < 0) { m_valid = false; return; }
+				skip(static_cast<size_t>(count) * ply_type_size(iProperty.m_type));
+			}
+			else
+			{
+				skip(ply_type_size(iProperty.m_type));
+			}
+		}
+	};
+
+	bool parse_ply_header(std::string const& iHeader, bool& oBinaryLittleEndian, std::vector<PlyElement>& oElements, std::string& oError)
+	{
+		std::istringstream lines(iHeader);
+		std::string line;
+		std::getline(lines, line);
+		bool has_format = false;
+		while (std::getline(lines, line))
+		{
+			std::istringstream words(line);
+			std::string keyword;
+			words >> keyword;
+			if (keyword == "format")
+			{
+				std::string format;
+				words >> format;
+				if (format != "binary_little_endian" && format != "binary_big_endian")
+				{
+					oError = "unsupported PLY format " + format + ", only binary PLY is read";
+					return false;
+				}
+				oBinaryLittleEndian = (format == "binary_little_endian");
+				has_format = true;
+			}
+			else if (keyword == "element")
+			{
+				PlyElement element;
+				words >> element.m_name >> element.m_count;
+				if (!words)
+				{
+					oError = "malformed PLY element : " + line;
+					return false;
+				}
+				oElements.push_back(element);
+			}
+			else if (keyword == "property")
+			{
+				PlyProperty property;
+				std::string type;
+				words >> type;
+				if (type == "list")
+				{
+					std::string count_type;
+					words >> count_type >> type;
+					property.m_is_list = true;
+					if (!ply_type(count_type, property.m_count_type))
+					{
+						oError = "unknown PLY type " + count_type;
+						return false;
+					}
+				}
+				words >> property.m_name;
+				if (!ply_type(type, property.m_type) || oElements.empty())
+				{
+					oError = "malformed PLY property : " + line;
+					return false;
+				}
+				oElements.back().m_properties.push_back(property);
+			}
+		}
+
+		if (!has_format)
+		{
+			oError = "missing PLY format";
+			return false;
+		}
+		return true;
+	}
+
+	void read_ply_vertices(ByteReader& ioReader, PlyElement const& iElement, std::vector<glm::vec3>& oVertex, std::string& oError)
+	{
+		int axis_of_property[3] = { -1, -1, -1 };
+		bool has_list = false;
+		for (size_t p = 0; p < iElement.m_properties.size(); ++p)
+		{
+			PlyProperty const& property = iElement.m_properties[p];
+			has_list = has_list || property.m_is_list;
+			if (property.m_name == "x") { axis_of_property[0] = static_cast<int>(p); }
+			if (property.m_name == "y") { axis_of_property[1] = static_cast<int>(p); }
+			if (property.m_name == "z") { axis_of_property[2] = static_cast<int>(p); }
+		}
+		if (axis_of_property[0] < 0 || axis_of_property[1] < 0 || axis_of_property[2] < 0)
+		{
+			oError = "PLY vertex element without x, y and z";
+			ioReader.m_valid = false;
+			return;
+		}
+
+		size_t first = oVertex.size();
+		oVertex.resize(first + iElement.m_count);
+		for (size_t i = 0; i < iElement.m_count && ioReader.m_valid; ++i)
+		{
+			glm::vec3& v = oVertex[first + i];
+			for (size_t p = 0; p < iElement.m_properties.size(); ++p)
+			{
+				PlyProperty const& property = iElement.m_properties[p];
+				if (static_cast<int>(p) == axis_of_property[0]) { v.x = static_cast<float>(ioReader.read_value(property.m_type)); }
+				else if (static_cast<int>(p) == axis_of_property[1]) { v.y = static_cast<float>(ioReader.read_value(property.m_type)); }
+				else if (static_cast<int>(p) == axis_of_property[2]) { v.z = static_cast<float>(ioReader.read_value(property.m_type)); }
+				else { ioReader.skip_property(property); }
+			}
+		}
+	}
+
+	void read_ply_faces(ByteReader& ioReader, PlyElement const& iElement, std::vector<glm::ivec3>& oFace)
+	{
+		oFace.reserve(oFace.size() + iElement.m_count);
+		for (size_t i = 0; i < iElement.m_count && ioReader.m_valid; ++i)
+		{
+			for (PlyProperty const& property : iElement.m_properties)
+			{
+				if (!property.m_is_list || (property.m_name != "vertex_indices" && property.m_name != "vertex_index"))
+				{
+					ioReader.skip_property(property);
+					continue;
+				}
+
+				int64_t count = ioReader.read_integer(property.m_count_type);
+				int first = -1;
+				int previous = -1;
+				for (int64_t k = 0; k < count && ioReader.m_valid; ++k)
+				{
+					int current = static_cast<int>(ioReader.read_integer(property.m_type));
+					if (k == 0) { first = current; }
+					if (k >= 2) { oFace.emplace_back(first, previous, current); }
+					previous = current;
+				}
+			}
+		}
+	}
+
+	// faces index positions read before or after them, checked once everything is read
+	bool finish_faces(std::vector<glm::vec3> const& iVertex, std::vector<glm::ivec3> const& iFace, std::vector<unsigned int>& oIndex, std::string& oError)
+	{
+		if (iFace.empty())
+		{
+			oError = "no triangle";
+			return false;
+		}
+
+		int vertex_count = static_cast<int>(iVertex.size());
+		oIndex.resize(3 * iFace.size());
+		for (size_t f = 0; f < iFace.size(); ++f)
+		{
+			glm::ivec3 const& face = iFace[f];
+			if (glm::any(glm::lessThan(face, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(face, glm::ivec3(vertex_count))))
+			{
+				oError = "face " + std::to_string(f) + " references a missing vertex";
+				return false;
+			}
+			oIndex[3 * f] = face.x;
+			oIndex[3 * f + 1] = face.y;
+			oIndex[3 * f + 2] = face.z;
+		}
+		return true;
+	}
+
+	// open addressing table from quantized positions to vertex indices
+	struct WeldTable
+	{
+		struct Slot
+		{
+			uint32_t m_key[3];
+			int m_index;
+		};
+
+		WeldTable(size_t iExpectedVertexCount)
+		{
+			size_t capacity = 16;
+			while (capacity < 2 * iExpectedVertexCount) { capacity *= 2; }
+			m_slots.assign(capacity, Slot{ { 0, 0, 0 }, -1 });
+		}
+
+		// positions equal once rounded to 20 mantissa bits (about 1e-6 relative) share
+		// a vertex, +0 and -0 too. This merges the float noise of exporters, not nearby points.
+		static uint32_t quantize(float iValue)
+		{
+			if (iValue == 0.0f) { return 0; }
+			uint32_t bits;
+			std::memcpy(&bits, &iValue, sizeof(float));
+			return (bits + 4u) & ~7u;
+		}
+
+		static size_t hash(uint32_t const* iKey)
+		{
+			uint64_t h = iKey[0] * 0x9E3779B97F4A7C15ull;
+			h ^= iKey[1] * 0xC2B2AE3D27D4EB4Full;
+			h ^= iKey[2] * 0x165667B19E3779F9ull;
+			return static_cast<size_t>(h ^ (h >> 29));
+		}
+
+		int insert(glm::vec3 const& iPosition, std::vector<glm::vec3>& ioVertex)
+		{
+			if (2 * (m_count + 1) > m_slots.size()) { grow(); }
+
+			uint32_t key[3] = { quantize(iPosition.x), quantize(iPosition.y), quantize(iPosition.z) };
+			size_t mask = m_slots.size() - 1;
+			for (size_t s = hash(key) & mask; ; s = (s + 1) & mask)
+			{
+				Slot& slot = m_slots[s];
+				if (slot.m_index < 0)
+				{
+					std::memcpy(slot.m_key, key, sizeof(key));
+					slot.m_index = static_cast<int>(ioVertex.size());
+					ioVertex.push_back(iPosition);
+					++m_count;
+					return slot.m_index;
+				}
+				if (std::memcmp(slot.m_key, key, sizeof(key)) == 0)
+				{
+					return slot.m_index;
+				}
+			}
+		}
+
+		void grow()
+		{
+			std::vector<Slot> slots(2 * m_slots.size(), Slot{ { 0, 0, 0 }, -1 });
+			size_t mask = slots.size() - 1;
+			for (Slot const& slot : m_slots)
+			{
+				if (slot.m_index < 0) { continue; }
+				size_t s = hash(slot.m_key) & mask;
+				while (slots[s].m_index >= 0) { s = (s + 1) & mask; }
+				slots[s] = slot;
+			}
+			m_slots.swap(slots);
+		}
+
+		std::vector<Slot> m_slots;
+		size_t m_count = 0;
+	};
+}
+
+bool parse_ply(MappedFile const& iFile,
+	std::vector<glm::vec3>& oVertex, std::vector<glm::ivec3>& oFace, std::vector<unsigned int>& oIndex, std::string& oError)
+{
+	char const* begin = reinterpret_cast<char const*>(iFile.data());
+	char const* end = begin + iFile.size();
+	char const* const end_header = "end_header";
+	char const* header_end = std::search(begin, end, end_header, end_header + std::strlen(end_header));
+	if (iFile.size() < 4 || std::memcmp(begin, "ply", 3) != 0 || header_end == end)
+	{
+		oError = "not a PLY file";
+		return false;
+	}
+	char const* data = next_line(header_end, end);
+
+	bool little_endian = true;
+	std::vector<PlyElement> elements;
+	if (!parse_ply_header(std::string(begin, header_end), little_endian, elements, oError)) { return false; }
+
+	oVertex.clear();
+	oFace.clear();
+	ByteReader reader{ reinterpret_cast<unsigned char const*>(data), iFile.data() + iFile.size(), little_endian != host_is_little_endian() };
+	for (PlyElement const& element : elements)
+	{
+		// the header count sizes the buffers below : it must fit in the bytes left
+		size_t record_size = ply_min_record_size(element);
+		size_t remaining = static_cast<size_t>(reader.m_end - reader.m_pos);
+		if (element.m_count > 0 && (record_size == 0 || element.m_count > remaining / record_size))
+		{
+			oError = "truncated PLY " + element.m_name + " element";
+			return false;
+		}
+
+		if (element.m_name == "vertex")
+		{
+			read_ply_vertices(reader, element, oVertex, oError);
+		}
+		else if (element.m_name == "face")
+		{
+			read_ply_faces(reader, element, oFace);
+		}
+		else
+		{
+			for (size_t i = 0; i < element.m_count && reader.m_valid; ++i)
+			{
+				for (PlyProperty const& property : element.m_properties) { reader.skip_property(property); }
+			}
+		}
+
+		if (!reader.m_valid)
+		{
+			if (oError.empty()) { oError = "truncated PLY " + element.m_name + " element"; }
+			return false;
+		}
+	}
+
+	return finish_faces(oVertex, oFace, oIndex, oError);
+}
+
+bool parse_stl(MappedFile const& iFile,
+	std::vector<glm::vec3>& oVertex, std::vector<glm::ivec3>& oFace, std::vector<unsigned int>& oIndex, std::string& oError)
+{
+	// 80 bytes header, triangle count, then 50 bytes per triangle :
+	// normal, 3 corners and a 2 bytes attribute, little endian
+	size_t const header_size = 84;
+	size_t const triangle_size = 50;
+	if (iFile.size() < header_size)
+	{
+		oError = "not an STL file";
+		return false;
+	}
+
+	ByteReader reader{ iFile.data() + 80, iFile.data() + iFile.size(), !host_is_little_endian() };
+	size_t triangle_count = reader.read<uint32_t>();
+	if (header_size + triangle_count * triangle_size != iFile.size())
+	{
+		bool ascii = std::memcmp(iFile.data(), "solid", 5) == 0;
+		oError = ascii ? "ASCII STL is not supported, only binary STL is read" : "STL size does not match its triangle count";
+		return false;
+	}
+
+	oVertex.clear();
+	oFace.clear();
+	oFace.reserve(triangle_count);
+	// closed meshes have about half as many vertices as triangles
+	WeldTable welds(triangle_count / 2);
+	for (size_t t = 0; t < triangle_count; ++t)
+	{
+		reader.skip(3 * sizeof(float));
+		int corners[3];
+		for (int k = 0; k < 3; ++k)
+		{
+			glm::vec3 p;
+			p.x = reader.read<float>();
+			p.y = reader.read<float>();
+			p.z = reader.read<float>();
+			corners[k] = welds.insert(p, oVertex);
+		}
+		reader.skip(sizeof(uint16_t));
+		oFace.emplace_back(corners[0], corners[1], corners[2]);
+	}
+
+	return finish_faces(oVertex, oFace, oIndex, oError);
+}
+
+bool load_mesh_file(std::string const& iPath, ThreadPool& iPool,
+	std::vector<glm::vec3>& oVertex, std::vector<glm::ivec3>& oFace, std::vector<unsigned int>& oIndex, std::string& oError)
+{
+	MappedFile file(iPath);
+	if (!file.is_open())
+	{
+		oError = "cannot open file";
+		return false;
+	}
+
+	std::string extension = iPath.substr(std::min(iPath.size(), iPath.find_last_of('.')));
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	if (extension == ".obj") { return parse_obj(file, iPool, oVertex, oFace, oIndex, oError); }
+	if (extension == ".ply") { return parse_ply(file, oVertex, oFace, oIndex, oError); }
+	if (extension == ".stl") { return parse_stl(file, oVertex, oFace, oIndex, oError); }
+
+	oError = "unknown mesh format " + extension;
+	return false;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+
+// Wavefront OBJ : positions and faces only, polygons are fan triangulated and
+// negative (relative) indices are resolved. The file is split into line aligned
+// chunks that are counted, then parsed in parallel straight into the output arrays.
+// oIndex holds the same triangles as oFace, as a flat index buffer.
+bool parse_obj(MappedFile const& iFile, ThreadPool& iPool,
+	std::vector<glm::vec3>& oVertex, std::vector<glm::ivec3>& oFace, std::vector<unsigned int>& oIndex, std::string& oError);
+
+// binary PLY, little or big endian : x, y, z of the "vertex" element and the
+// "vertex_indices" list of the "face" element, fan triangulated. Other elements
+// and properties, lists included, are skipped.
+bool parse_ply(MappedFile const& iFile,
+	std::vector<glm::vec3>& oVertex, std::vector<glm::ivec3>& oFace, std::vector<unsigned int>& oIndex, std::string& oError);
+
+// binary STL. Triangles do not share vertices in STL : corners are welded while
+// reading through a hash table on quantized positions, which only grows with the
+// number of distinct vertices.
+bool parse_stl(MappedFile const& iFile,
+	std::vector<glm::vec3>& oVertex, std::vector<glm::ivec3>& oFace, std::vector<unsigned int>& oIndex, std::string& oError);
+
+// map iPath and pick the parser from its extension (.obj, .ply or .stl)
+bool load_mesh_file(std::string const& iPath, ThreadPool& iPool,
+	std::vector<glm::vec3>& oVertex, std::vector<glm::ivec3>& oFace, std::vector<unsigned int>& oIndex, std::string& oError);
@@ -1,8 +1,51 @@
 #include "application.h"
+#include <algorithm>
 
 std::shared_ptr<struct App> g_app;
 struct UI g_ui;
 
+// render on demand : the loop sleeps until an event, and a frame is only drawn when the camera,
+// the UI, the mesh or the window changed, plus a few more frames for ImGui to settle
+constexpr int g_settleFrames = 3;
+constexpr double g_idleTimeout = 0.5;		// seconds, wakes up the UI now and then even without events
+
+struct Redraw
+{
+	int m_pending = g_settleFrames;		// frames still to draw before sleeping again
+	uint64_t m_uiHash = 0;				// ImGui draw data of the last drawn frame
+};
+struct Redraw g_redraw;
+
+void request_redraw()
+{
+	g_redraw.m_pending = std::max(g_redraw.m_pending, g_settleFrames);
+}
+
+bool same_ui(struct UI const& iA, struct UI const& iB)
+{
+	return iA.draw_T1 == iB.draw_T1 && iA.draw_T2 == iB.draw_T2 &&
+		iA.draw_true_contours == iB.draw_true_contours && iA.draw_suggestive_contours == iB.draw_suggestive_contours &&
+		iA.object_space_contours == iB.object_space_contours && iA.edge_silhouettes == iB.edge_silhouettes &&
+		iA.contour_min_DwKn == iB.contour_min_DwKn && iA.contour_min_angle == iB.contour_min_angle &&
+		std::equal(iA.object_color, iA.object_color + 3, iB.object_color) &&
+		iA.shading_mode == iB.shading_mode && iA.max_Kn == iB.max_Kn && iA.glyph_spacing == iB.glyph_spacing;
+}
+
+// changes whenever the UI looks different : hover, edited values, animations
+uint64_t draw_data_hash(ImDrawData const* iDrawData)
+{
+	uint64_t hash = static_cast<uint64_t>(iDrawData->CmdListsCount);
+	for (ImDrawList const* list : iDrawData->CmdLists)
+	{
+		uint64_t parts[3] = {
+			hash,
+			hash_bytes(reinterpret_cast<unsigned char const*>(list->VtxBuffer.Data), list->VtxBuffer.size_in_bytes()),
+			hash_bytes(reinterpret_cast<unsigned char const*>(list->IdxBuffer.Data), list->IdxBuffer.size_in_bytes()) };
+		hash = hash_bytes(reinterpret_cast<unsigned char const*>(parts), sizeof(parts));
+	}
+	return hash;
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
 	glViewport(0, 0, width, height);
@@ -10,6 +53,12 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 	g_app->m_viewport.m_height = height;
 	g_app->m_viewport.m_aspect_ratio = static_cast<float>(g_app->m_viewport.m_width) / static_cast<float>(g_app->m_viewport.m_height);
 	g_app->m_cam.updateView(g_app->m_cam.m_position, g_app->m_cam.m_lookAt, glm::vec3(0.0f, 1.0f, 0.0f), g_app->m_viewport.m_aspect_ratio);
+	request_redraw();
+}
+
+void window_refresh_callback(GLFWwindow*)
+{
+	request_redraw();
 }
 
 void processInput(GLFWwindow* window)
@@ -19,9 +68,10 @@ void processInput(GLFWwindow* window)
 		glfwSetWindowShouldClose(window, true);
 	}
 
-	if (glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS) // recompile fragment shader
+	if (glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS) // recompile fragment shader variants
 	{
-		g_app->m_mainShader = std::make_shared<Shader>("shaders/vertex.glsl", "shaders/fragment.glsl");
+		g_app->m_mainShaders.clear();
+		request_redraw();
 	}
 
 	// camera related
@@ -32,7 +82,8 @@ void processInput(GLFWwindow* window)
 	g_app->m_mouse.m_prevY = g_app->m_mouse.m_currY;
 	g_app->m_mouse.m_currX = xpos;
 	g_app->m_mouse.m_currY = ypos;
-	if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_3) == GLFW_PRESS)
+	bool moved = g_app->m_mouse.m_currX != g_app->m_mouse.m_prevX || g_app->m_mouse.m_currY != g_app->m_mouse.m_prevY;
+	if (moved && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_3) == GLFW_PRESS)
 	{
 		g_app->m_mouse.m_changed = true;
 	}
@@ -52,6 +103,7 @@ void draw_UI()
 	if (ImGui::Button("process"))
 	{
 		g_app->m_mesh.taubin_smoothing();
+		request_redraw();
 	}
 	ImGui::End();
 	
@@ -65,106 +117,101 @@ void draw_UI()
 	ImGui::End();
 
 	ImGui::SetNextWindowPos(ImVec2(0, 250));
-	ImGui::SetNextWindowSize(ImVec2(300, 100));
+	ImGui::SetNextWindowSize(ImVec2(300, 190));
 	ImGui::Begin("Suggestive Contours settings");
 	if (g_ui.shading_mode == SM_SUGGESTIVE_CONTOURS)
 	{
 		ImGui::SliderFloat("max Kn", &g_ui.max_Kn, 0.0f, 0.2f);
 		ImGui::Checkbox("Draw true contours", &g_ui.draw_true_contours);
 		ImGui::Checkbox("Draw suggestive_contours", &g_ui.draw_suggestive_contours);
+		ImGui::Checkbox("Object space lines", &g_ui.object_space_contours);
+		if (g_ui.object_space_contours)
+		{
+			ImGui::Checkbox("Mesh edge silhouettes", &g_ui.edge_silhouettes);
+			ImGui::SliderFloat("min DwKn", &g_ui.contour_min_DwKn, 0.0f, 10.0f);
+			ImGui::SliderFloat("min angle", &g_ui.contour_min_angle, 0.0f, 30.0f);
+		}
 	}
 	ImGui::End();
 
-	ImGui::SetNextWindowPos(ImVec2(0, 350));
+	ImGui::SetNextWindowPos(ImVec2(0, 440));
 	ImGui::SetNextWindowSize(ImVec2(300, 100));
 	ImGui::Begin("Principal curvatures' directions");
 	ImGui::Checkbox("Draw principal direction T1 (max)", &g_ui.draw_T1);
 	ImGui::Checkbox("Draw principal direction T2 (min)", &g_ui.draw_T2);
+	ImGui::SliderFloat("spacing (px)", &g_ui.glyph_spacing, 0.0f, 40.0f);
 	ImGui::End();
 }
 
 void draw_mesh()
 {
-	// render mesh
-	glBindVertexArray(g_app->m_mesh.m_vao);
+	// matrices and UI parameters of every program
+	g_app->update_frame_uniforms(g_ui);
 
-	glUseProgram(g_app->m_mainShader->m_program);
-	g_app->m_mainShader->setMat4f("model", g_app->m_mesh.m_model);
-	g_app->m_mainShader->setMat4f("view", g_app->m_cam.m_view);
-	g_app->m_mainShader->setMat4f("proj", g_app->m_cam.m_proj);
-	g_app->m_mainShader->setVec3f("viewPosition", g_app->m_cam.m_position);
-	g_app->m_mainShader->setVec3f("objectColor", glm::vec3(g_ui.object_color[0], g_ui.object_color[1], g_ui.object_color[2]));
-	g_app->m_mainShader->setInt("shading_mode", g_ui.shading_mode);
-	if (g_ui.draw_true_contours)
-	{
-		g_app->m_mainShader->setBool("draw_true_contours", true);
-	}
-	else
-	{
-		g_app->m_mainShader->setBool("draw_true_contours", false);
-	}
-	if (g_ui.draw_suggestive_contours)
+	// render mesh
+	glUseProgram(g_app->main_shader(g_ui).m_program);
+	if (g_ui.shading_mode == SM_COLOR && g_app->m_mesh.m_wireframe)
 	{
-		g_app->m_mainShader->setBool("draw_suggestive_contours", true);
+		g_app->m_mesh.draw_wireframe();
 	}
 	else
 	{
-		g_app->m_mainShader->setBool("draw_suggestive_contours", false);
-	}
-	g_app->m_mainShader->setFloat("max_Kn", g_ui.max_Kn);
-	g_app->m_mainShader->setFloat("minKg", g_app->m_mesh.m_geom.m_minKg);
-	g_app->m_mainShader->setFloat("maxKg", g_app->m_mesh.m_geom.m_maxKg);
-	g_app->m_mainShader->setFloat("minH", g_app->m_mesh.m_geom.m_minH);
-	g_app->m_mainShader->setFloat("maxH", g_app->m_mesh.m_geom.m_maxH);
-	glDrawElements(GL_TRIANGLES, g_app->m_mesh.m_geom.m_index.size(), GL_UNSIGNED_INT, 0);
-	if (g_ui.shading_mode == SM_COLOR)
-	{
-		glLineWidth(1.5f);
-		glUseProgram(g_app->m_wireframeShader.m_program);
-		g_app->m_wireframeShader.setMat4f("model", g_app->m_mesh.m_model);
-		g_app->m_wireframeShader.setMat4f("view", g_app->m_cam.m_view);
-		g_app->m_wireframeShader.setMat4f("proj", g_app->m_cam.m_proj);
+		glBindVertexArray(g_app->m_mesh.m_vao);
 		glDrawElements(GL_TRIANGLES, g_app->m_mesh.m_geom.m_index.size(), GL_UNSIGNED_INT, 0);
-		glLineWidth(2.5f);
 	}
 
-	if (g_ui.draw_T1)
+	// suggestive contours and silhouettes extracted from the camera position in object space,
+	// update_contour_lines keeps the lines of the last frame while the view, the options and the mesh hold
+	if (g_ui.shading_mode == SM_SUGGESTIVE_CONTOURS && g_ui.object_space_contours && (g_ui.draw_suggestive_contours || g_ui.draw_true_contours))
 	{
-		glUseProgram(g_app->m_principalDirT1.m_program);
-		g_app->m_principalDirT1.setMat4f("model", g_app->m_mesh.m_model);
-		g_app->m_principalDirT1.setMat4f("view", g_app->m_cam.m_view);
-		g_app->m_principalDirT1.setMat4f("proj", g_app->m_cam.m_proj);
-		glDrawElements(GL_TRIANGLES, g_app->m_mesh.m_geom.m_index.size(), GL_UNSIGNED_INT, 0);
+		SuggestiveContourOptions options;
+		options.m_min_derivative = g_ui.contour_min_DwKn;
+		options.m_min_angle = glm::radians(g_ui.contour_min_angle);
+		glm::vec3 view_position = glm::vec3(glm::inverse(g_app->m_mesh.m_model) * glm::vec4(g_app->m_cam.m_position, 1.0f));
+		g_app->m_mesh.update_contour_lines(view_position, g_ui.draw_suggestive_contours, options, g_ui.draw_true_contours, g_ui.edge_silhouettes);
+		glUseProgram(g_app->m_contourLines.m_program);
+		g_app->m_mesh.draw_contour_lines();
 	}
 
-	if (g_ui.draw_T2)
+	// principal directions
+	if (g_ui.draw_T1 || g_ui.draw_T2)
 	{
-		glUseProgram(g_app->m_principalDirT2.m_program);
-		g_app->m_principalDirT2.setMat4f("model", g_app->m_mesh.m_model);
-		g_app->m_principalDirT2.setMat4f("view", g_app->m_cam.m_view);
-		g_app->m_principalDirT2.setMat4f("proj", g_app->m_cam.m_proj);
-		glDrawElements(GL_TRIANGLES, g_app->m_mesh.m_geom.m_index.size(), GL_UNSIGNED_INT, 0);
+		glUseProgram(g_app->m_principalDirections.m_program);
+		g_app->m_mesh.draw_glyphs(g_ui.draw_T1, g_ui.draw_T2, g_app->glyph_stride(g_ui.glyph_spacing));
 	}
-
 	glBindVertexArray(0);
 }
 
-void render()
+// the UI is built every time the loop wakes up, the frame is only drawn when something changed
+bool render()
 {
 	// ImGui new frame
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
 
+	// UI, before the mesh so that it is drawn with the new values
+	struct UI previous = g_ui;
+	draw_UI();
+	ImGui::Render();
+	uint64_t ui_hash = draw_data_hash(ImGui::GetDrawData());
+	if (!same_ui(previous, g_ui) || ui_hash != g_redraw.m_uiHash)
+	{
+		request_redraw();
+	}
+	if (g_redraw.m_pending == 0)
+	{
+		return false;
+	}
+
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	draw_mesh();
-
-	// draw UI
-	draw_UI();
-
-	ImGui::Render();
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+	g_redraw.m_uiHash = ui_hash;
+	--g_redraw.m_pending;
+	return true;
 }
 
 void ImGui_init(GLFWwindow* win)
@@ -180,6 +227,13 @@ void ImGui_init(GLFWwindow* win)
 
 int main(int argc, char* argv[])
 {
+	// suggestive_contours [mesh options], the benchmarks are in suggestive_contours_bench
+	MeshOptions mesh_options;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!mesh_options.parse(argv[i])) { std::cerr << "WARN: unknown argument " << argv[i] << std::endl; }
+	}
+
 	// init glfw
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -219,25 +273,42 @@ int main(int argc, char* argv[])
 	g_ui.shading_mode = SM_COLOR;
 	g_ui.draw_true_contours = false;
 	g_ui.draw_suggestive_contours = false;
+	g_ui.object_space_contours = false;
+	g_ui.edge_silhouettes = false;
+	g_ui.contour_min_DwKn = 0.0f;
+	g_ui.contour_min_angle = 0.0f;
 	g_ui.max_Kn = 0.085f;
+	g_ui.glyph_spacing = 0.0f;
 
 	// application render loop
-	g_app = std::make_unique<struct App>();
+	g_app = std::make_unique<struct App>(mesh_options);
 	glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+	glfwSetWindowRefreshCallback(window, window_refresh_callback);
 
 	while (!glfwWindowShouldClose(window))
 	{
+		// only poll while frames are pending, else sleep until the next event
+		if (g_redraw.m_pending > 0)
+		{
+			glfwPollEvents();
+		}
+		else
+		{
+			glfwWaitEventsTimeout(g_idleTimeout);
+		}
+
 		processInput(window);
 		if (g_app->m_mouse.m_changed)
 		{
 			g_app->m_cam.rotateView(g_app->m_mouse, g_app->m_viewport);
 			g_app->m_mouse.m_changed = false;
+			request_redraw();
 		}
 
-		render();
-
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		if (render())
+		{
+			glfwSwapBuffers(window);
+		}
 	}
 
 	// clean ImGui
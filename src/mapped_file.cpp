@@ -0,0 +1,98 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(std::string const& iPath)
+{
+	open(iPath);
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(std::string const& iPath)
+{
+	close();
+	HANDLE file = CreateFileA(iPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) { return false; }
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!data)
+	{
+		if (mapping) { CloseHandle(mapping); }
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_data = static_cast<unsigned char const*>(data);
+	m_size = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data) { UnmapViewOfFile(m_data); }
+	if (m_mapping) { CloseHandle(m_mapping); }
+	if (m_file) { CloseHandle(m_file); }
+	m_data = nullptr;
+	m_size = 0;
+	m_file = nullptr;
+	m_mapping = nullptr;
+}
+
+#else
+
+bool MappedFile::open(std::string const& iPath)
+{
+	close();
+	int fd = ::open(iPath.c_str(), O_RDONLY);
+	if (fd < 0) { return false; }
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	// the mapping keeps the file referenced, the descriptor is not needed anymore
+	void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED) { return false; }
+
+	m_data = static_cast<unsigned char const*>(data);
+	m_size = static_cast<size_t>(st.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data) { munmap(const_cast<unsigned char*>(m_data), m_size); }
+	m_data = nullptr;
+	m_size = 0;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// read only memory mapping of a whole file
+struct MappedFile
+{
+	MappedFile() = default;
+	MappedFile(std::string const& iPath);
+	~MappedFile();
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	bool open(std::string const& iPath);
+	void close();
+	bool is_open() const { return m_data != nullptr; }
+	unsigned char const* data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+	unsigned char const* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	void* m_file = nullptr;
+	void* m_mapping = nullptr;
+#endif
+};
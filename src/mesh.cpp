@@ -1,365 +1,574 @@
 #include "mesh.hpp"
-
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
-
-// Create a mesh from an OBJ file
-Mesh::Mesh(std::string const & iPath)
+#include "loader.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+uint64_t MeshOptions::cache_key(uint64_t iSourceHash) const
 {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::string warn;
-	std::string err;
-
-	bool triangulate = true;
-	tinyobj::LoadObj(&attrib, &shapes, nullptr, &warn, &err, iPath.c_str(), nullptr, triangulate);
-	if (!warn.empty()) { std::cerr << "WARN: " << warn << std::endl; }
-	if (!err.empty()) { std::cerr << err << std::endl; }
+	uint32_t tolerance;
+	std::memcpy(&tolerance, &m_cleanup.m_weld_tolerance, sizeof(float));
+	uint64_t const key[] = { iSourceHash, m_cleanup.m_weld, m_cleanup.m_cull_faces, tolerance, m_reorder, m_draw_order };
+	return hash_bytes(reinterpret_cast<unsigned char const*>(key), sizeof(key));
+}
 
-	for (size_t v = 0; v < attrib.vertices.size(); v += 3)
+// --weld[=tolerance] : merge vertices closer than tolerance * bounding box diagonal, and cull faces
+// --cull : remove degenerate and duplicate faces
+// --reorder : sort vertices and faces along a space filling curve
+// --draw-order : sort faces for the vertex cache and against overdraw
+bool MeshOptions::parse(char const* iArg)
+{
+	if (std::strncmp(iArg, "--weld", 6) == 0 && (iArg[6] == '\0' || iArg[6] == '='))
 	{
-		m_geom.m_vertex.emplace_back(attrib.vertices[v], attrib.vertices[v + 1], attrib.vertices[v + 2]);
+		m_cleanup.m_weld = true;
+		m_cleanup.m_cull_faces = true;
+		if (iArg[6] == '=') { m_cleanup.m_weld_tolerance = std::strtof(iArg + 7, nullptr); }
+		return true;
 	}
-
-	std::vector<tinyobj::index_t> const& indices = shapes[0].mesh.indices;
-	m_geom.m_vertex_normal.resize(m_geom.m_vertex.size());
-	m_geom.m_neighboring_faces.resize(m_geom.m_vertex.size());
-	m_geom.m_neighboring_vertices.resize(m_geom.m_vertex.size());
-	m_geom.m_face_normal.resize(indices.size() / 3);
-
-	for (size_t i = 0; i < indices.size(); i += 3)
-	{
-		int v0 = indices[i].vertex_index;
-		int v1 = indices[i+1].vertex_index;
-		int v2 = indices[i+2].vertex_index;
-		m_geom.m_face.emplace_back(v0, v1, v2);
-		m_geom.m_index.push_back(v0);
-		m_geom.m_index.push_back(v1);
-		m_geom.m_index.push_back(v2);
-
-		// compute face normal
-		glm::vec3 e0 = m_geom.m_vertex[v1] - m_geom.m_vertex[v0];
-		glm::vec3 e1 = m_geom.m_vertex[v2] - m_geom.m_vertex[v0];
-		glm::vec3 normal = glm::normalize(glm::cross(e0, e1));
-		m_geom.m_face_normal[i/3] = normal;
+	if (std::strcmp(iArg, "--cull") == 0)
+	{
+		m_cleanup.m_cull_faces = true;
+		return true;
+	}
+	if (std::strcmp(iArg, "--reorder") == 0)
+	{
+		m_reorder = true;
+		return true;
+	}
+	if (std::strcmp(iArg, "--draw-order") == 0)
+	{
+		m_draw_order = true;
+		return true;
 	}
+	return false;
+}
 
-	// compute vertex normal
-	for (size_t i = 0; i < m_geom.m_vertex.size(); ++i)
+// Create a mesh from an OBJ, PLY or STL file, or from its curvature cache when it is up to date
+Mesh::Mesh(std::string const & iPath, MeshOptions const& iOptions)
+{
+	// the cache holds the result of the load options too
+	MappedFile source(iPath);
+	bool readable = source.is_open() && source.size() > 0;
+	uint64_t source_hash = iOptions.cache_key(hash_bytes(source.data(), source.size()));
+	uint64_t source_size = source.size();
+	source.close();
+
+	CurvatureCache cache;
+	std::string cache_path = CurvatureCache::path_for(iPath);
+	if (readable && cache.open(cache_path, source_hash, source_size))
 	{
-		std::vector<int> neighboring_faces;
-		std::vector<int> neighboring_vertices;
-		get_neighbors(i, neighboring_vertices, neighboring_faces);
+		m_geom.load_streams(cache.streams());
 
-		glm::vec3 vertex_normal(0.0f, 0.0f, 0.0f);
-		for (int const& face_idx : neighboring_faces)
+		// vertex/face adjacency
+		m_geom.compute_adjacency();
+
+		// send the mapped vertices to GPU as they are
+		create_GPU_objects(cache.streams());
+	}
+	else
+	{
+		bool loaded = m_geom.load(iPath, ThreadPool::global());
+		m_geom.cleanup(ThreadPool::global(), iOptions.m_cleanup);
+		if (iOptions.m_reorder) { m_geom.reorder(ThreadPool::global()); }
+		if (iOptions.m_draw_order) { m_geom.optimize_draw_order(); }
+
+		// vertex/face adjacency
+		m_geom.compute_adjacency();
+
+		// normals, curvatures and their derivatives
+		m_geom.compute_curvatures(ThreadPool::global());
+
+		// send geometry data to GPU, packed once for the VBO and the cache
+		GeometryStreams streams(m_geom);
+		std::vector<PackedVertex> packed(m_geom.m_vertex.size());
+		pack_vertices(ThreadPool::global(), streams.m_streams, packed.data());
+		streams.m_streams.m_packed = packed.data();
+		create_GPU_objects(streams.m_streams);
+
+		// a failed load leaves an empty mesh, which is never cached
+		if (!loaded || m_geom.m_vertex.empty() || m_geom.m_face.empty())
 		{
-			glm::vec3 face_normal = m_geom.m_face_normal[face_idx];
-			vertex_normal += face_normal;
+			std::cerr << "ERROR: " << iPath << " : no mesh loaded, the curvature cache is not written" << std::endl;
+		}
+		else if (!CurvatureCache::write(cache_path, source_hash, source_size, streams.m_streams))
+		{
+			std::cerr << "WARN: could not write curvature cache " << cache_path << std::endl;
 		}
-		vertex_normal = glm::normalize(vertex_normal);
-
-		m_geom.m_vertex_normal[i] = vertex_normal;
-		m_geom.m_neighboring_faces[i] = neighboring_faces;
-		m_geom.m_neighboring_vertices[i] = neighboring_vertices;
 	}
 
-	// compute per face weingarten's matrix
-	m_geom.compute_per_face_weingarten_matrix();
-
-	// compute per vertex weingarten's matrix
-	m_geom.m_t1.resize(m_geom.m_vertex.size());
-	m_geom.m_t2.resize(m_geom.m_vertex.size());
-	m_geom.m_K1.resize(m_geom.m_vertex.size());
-	m_geom.m_K2.resize(m_geom.m_vertex.size());
-	m_geom.compute_per_vertex_weingarten_matrix();
-
-	// compute min & max (Kg & H)
-	m_geom.m_minKg = 0.0f;
-	m_geom.m_maxKg = 0.0f;
-	m_geom.m_minH = 0.0f;
-	m_geom.m_maxH = 0.0f;
-	m_geom.compute_min_max();
-
-	// compute C matrix
-	m_geom.m_face_C.resize(m_geom.m_face.size());
-	m_geom.m_vertex_C.resize(m_geom.m_vertex.size());
-	m_geom.compute_per_face_C();
-	m_geom.compute_per_vertex_C();
-
-	// send geometry data to GPU
-	create_GPU_objects();
-
 	// model matrix
 	m_model = glm::mat4(1.0f);
-
-	// geometry's circulant matrix
-	m_geom.compute_circulant_matrix();
-
-	// low-pass transfer function
-	m_geom.Kpb = 0.095f;
-	m_geom.lambda = 0.6307f;
-	m_geom.N = 25;
-	m_geom.mu = m_geom.lambda / ((m_geom.lambda * m_geom.Kpb) - 1.0f); // from 1/lambda + 1/mu = Kpb
 }
 
 Mesh::~Mesh()
 {
 	glBindVertexArray(m_vao);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glDeleteBuffers(1, &m_posvbo);
-	glDeleteBuffers(1, &m_normalvbo);
-	glDeleteBuffers(1, &m_tangent_U);
-	glDeleteBuffers(1, &m_tangent_V);
-	glDeleteBuffers(1, &m_K1Vbo);
-	glDeleteBuffers(1, &m_K2Vbo);
-	glDeleteBuffers(1, &m_T1Vbo);
-	glDeleteBuffers(1, &m_T2Vbo);
+	for (int b = 0; b < 2; ++b)
+	{
+		if (m_vbo_fence[b] != nullptr) { glDeleteSync(m_vbo_fence[b]); }
+		if (m_vbo[b] != 0) { glDeleteBuffers(1, &m_vbo[b]); }
+	}
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 	glDeleteBuffers(1, &m_ebo);
+	glDeleteTextures(1, &m_vertex_texture);
+	glDeleteTextures(1, &m_index_texture);
 	glBindVertexArray(0);
 	glDeleteVertexArrays(1, &m_vao);
+	glDeleteVertexArrays(1, &m_glyph_vao);
+	glDeleteVertexArrays(1, &m_wireframe_vao);
+	glDeleteBuffers(1, &m_contour_vbo);
+	glDeleteVertexArrays(1, &m_contour_vao);
+}
+
+GeometryStreams::GeometryStreams(Geometry const& iGeom)
+{
+	// tangent plane to each vertex and C tensors, split as the VBOs expect them
+	size_t count = iGeom.m_vertex.size();
+	m_tangent_u.resize(count);
+	m_tangent_v.resize(count);
+	m_C1.resize(count);
+	m_C2.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_tangent_u[i] = iGeom.m_vertex_coordSys[i].m_u;
+		m_tangent_v[i] = iGeom.m_vertex_coordSys[i].m_v;
+		m_C1[i] = iGeom.m_vertex_C[i].m_a;
+		m_C2[i] = iGeom.m_vertex_C[i].m_b;
+	}
+
+	m_streams.m_vertex_count = count;
+	m_streams.m_index_count = iGeom.m_index.size();
+	m_streams.m_position = iGeom.m_vertex.data();
+	m_streams.m_normal = iGeom.m_vertex_normal.data();
+	m_streams.m_tangent_u = m_tangent_u.data();
+	m_streams.m_tangent_v = m_tangent_v.data();
+	m_streams.m_K1 = iGeom.m_K1.data();
+	m_streams.m_K2 = iGeom.m_K2.data();
+	m_streams.m_t1 = iGeom.m_t1.data();
+	m_streams.m_t2 = iGeom.m_t2.data();
+	m_streams.m_C1 = m_C1.data();
+	m_streams.m_C2 = m_C2.data();
+	m_streams.m_index = iGeom.m_index.data();
 }
 
-void Mesh::create_GPU_objects()
+void Mesh::create_GPU_objects(VertexStreams const& iStreams)
 {
 	// VAO
 	glGenVertexArrays(1, &m_vao);
 	glBindVertexArray(m_vao);
 
-	// POSITION VBO
-	glGenBuffers(1, &m_posvbo);
-	glBindBuffer(GL_ARRAY_BUFFER, m_posvbo);
-	glBufferData(GL_ARRAY_BUFFER, m_geom.m_vertex.size() * sizeof(glm::vec3), m_geom.m_vertex.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	// NORMAL VBO
-	glGenBuffers(1, &m_normalvbo);
-	glBindBuffer(GL_ARRAY_BUFFER, m_normalvbo);
-	glBufferData(GL_ARRAY_BUFFER, m_geom.m_vertex_normal.size() * sizeof(glm::vec3), m_geom.m_vertex_normal.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-	glEnableVertexAttribArray(1);
-
-
-	// tangent plane to each vertex
-	std::vector<glm::vec3> tangentU;
-	std::vector<glm::vec3> tangentV;
-	for (size_t i = 0; i < m_geom.m_vertex_coordSys.size(); ++i)
+	// INTERLEAVED VBO, the second one is only created when the vertices change
+	m_vbo[1] = 0;
+	m_vbo_fence[0] = nullptr;
+	m_vbo_fence[1] = nullptr;
+	m_current_vbo = 0;
+	glGenBuffers(1, &m_vbo[0]);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo[0]);
+	glBufferData(GL_ARRAY_BUFFER, iStreams.m_vertex_count * sizeof(PackedVertex), iStreams.m_packed, GL_DYNAMIC_DRAW);
+	// an empty range can not be mapped, a mesh that failed to load has no vertices
+	if (iStreams.m_packed == nullptr && iStreams.m_vertex_count > 0)
 	{
-		glm::vec3 u = m_geom.m_vertex_coordSys[i].m_u;
-		glm::vec3 v = m_geom.m_vertex_coordSys[i].m_v;
-		tangentU.push_back(u);
-		tangentV.push_back(v);
+		PackedVertex* vertices = reinterpret_cast<PackedVertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, iStreams.m_vertex_count * sizeof(PackedVertex), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+		pack_vertices(ThreadPool::global(), iStreams, vertices);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
 	}
+	bind_vertex_buffer(m_vbo[0]);
 
-	// TANGENT PLANE U
-	glGenBuffers(1, &m_tangent_U);
-	glBindBuffer(GL_ARRAY_BUFFER, m_tangent_U);
-	glBufferData(GL_ARRAY_BUFFER, tangentU.size() * sizeof(glm::vec3), tangentU.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-	glEnableVertexAttribArray(2);
-
-	// TANGENT PLANE V
-	glGenBuffers(1, &m_tangent_V);
-	glBindBuffer(GL_ARRAY_BUFFER, m_tangent_V);
-	glBufferData(GL_ARRAY_BUFFER, tangentV.size() * sizeof(glm::vec3), tangentV.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-	glEnableVertexAttribArray(3);
-
-	// K1 PRINCIPAL CURVATURE VBO
-	glGenBuffers(1, &m_K1Vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, m_K1Vbo);
-	glBufferData(GL_ARRAY_BUFFER, m_geom.m_K1.size() * sizeof(float), m_geom.m_K1.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
-	glEnableVertexAttribArray(4);
+	// ELEMENT EBO
+	glGenBuffers(1, &m_ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, iStreams.m_index_count * sizeof(unsigned int), iStreams.m_index, GL_STATIC_DRAW);
 
-	// K2 PRINCIPAL CURVATURE VBO
-	glGenBuffers(1, &m_K2Vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, m_K2Vbo);
-	glBufferData(GL_ARRAY_BUFFER, m_geom.m_K2.size() * sizeof(float), m_geom.m_K2.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)0);
-	glEnableVertexAttribArray(5);
-
-	// tensor T1 PRINCIPAL DIRECTION VBO
-	glGenBuffers(1, &m_T1Vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, m_T1Vbo);
-	glBufferData(GL_ARRAY_BUFFER, m_geom.m_t1.size() * sizeof(glm::vec3), m_geom.m_t1.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-	glEnableVertexAttribArray(6);
+	// Unbind VAO
+	glBindVertexArray(0);
 
-	// tensor T2 PRINCIPAL DIRECTION VBO
-	glGenBuffers(1, &m_T2Vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, m_T2Vbo);
-	glBufferData(GL_ARRAY_BUFFER, m_geom.m_t2.size() * sizeof(glm::vec3), m_geom.m_t2.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-	glEnableVertexAttribArray(7);
+	// BUFFER TEXTURES over the VBO and the EBO, no copy
+	GLint max_texels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &max_texels);
+	size_t vertex_texels = iStreams.m_vertex_count * sizeof(PackedVertex) / sizeof(glm::vec2);
+	m_wireframe = vertex_texels <= static_cast<size_t>(max_texels) && iStreams.m_index_count / 3 <= static_cast<size_t>(max_texels);
+	if (!m_wireframe)
+	{
+		std::cerr << "WARN: mesh larger than the buffer textures (" << max_texels << " texels), the wireframe is not drawn" << std::endl;
+	}
+	glGenTextures(1, &m_vertex_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_vertex_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, m_vbo[0]);
+	glGenTextures(1, &m_index_texture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_index_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGB32UI, m_ebo);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	// WIREFRAME VAO, no attribute : the vertices are read from the buffer textures
+	glGenVertexArrays(1, &m_wireframe_vao);
+
+	// GLYPH VAO, same buffer read one vertex per instance
+	m_glyph_stride = 1;
+	glGenVertexArrays(1, &m_glyph_vao);
+	glBindVertexArray(m_glyph_vao);
+	bind_glyph_buffer(m_vbo[0], m_glyph_stride);
+	glBindVertexArray(0);
 
-	// tensor C1 VBO
-	std::vector<glm::mat2> C1;
-	for (auto const& m : m_geom.m_vertex_C) { C1.push_back(m.m_a); }
-	glGenBuffers(1, &m_C1Vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, m_C1Vbo);
-	glBufferData(GL_ARRAY_BUFFER, C1.size() * sizeof(glm::mat2), C1.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat2), (void*)0);
-	glEnableVertexAttribArray(8);
+	// CONTOUR VAO, filled when the view changes
+	m_version = 0;
+	m_contour_capacity = 0;
+	m_contour_vertex_count = 0;
+	m_has_contour_lines = false;
+	glGenVertexArrays(1, &m_contour_vao);
+	glBindVertexArray(m_contour_vao);
+	glGenBuffers(1, &m_contour_vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, m_contour_vbo);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+	glEnableVertexAttribArray(0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_contours.build(ThreadPool::global(), iStreams);
+	m_silhouettes.build(m_geom.m_vertex, m_geom.m_vertex_normal, m_geom.m_corners);
 
-	// tensor C2 VBO
-	std::vector<glm::mat2> C2;
-	for (auto const& m : m_geom.m_vertex_C) { C2.push_back(m.m_b); }
-	glGenBuffers(1, &m_C2Vbo);
-	glBindBuffer(GL_ARRAY_BUFFER, m_C2Vbo);
-	glBufferData(GL_ARRAY_BUFFER, C2.size() * sizeof(glm::mat2), C2.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(9, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat2), (void*)0);
-	glEnableVertexAttribArray(9);
+	// bounding sphere around the box center
+	glm::vec3 min_corner(std::numeric_limits<float>::max());
+	glm::vec3 max_corner(-std::numeric_limits<float>::max());
+	for (size_t i = 0; i < iStreams.m_vertex_count; ++i)
+	{
+		min_corner = glm::min(min_corner, iStreams.m_position[i]);
+		max_corner = glm::max(max_corner, iStreams.m_position[i]);
+	}
+	m_center = (iStreams.m_vertex_count > 0) ? 0.5f * (min_corner + max_corner) : glm::vec3(0.0f);
+	m_radius = 0.0f;
+	for (size_t i = 0; i < iStreams.m_vertex_count; ++i)
+	{
+		m_radius = std::max(m_radius, glm::length(iStreams.m_position[i] - m_center));
+	}
+}
 
-	// ELEMENT EBO
-	glGenBuffers(1, &m_ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_geom.m_index.size() * sizeof(unsigned int), m_geom.m_index.data(), GL_STATIC_DRAW);
+void Mesh::bind_buffer_textures() const
+{
+	glActiveTexture(GL_TEXTURE0 + g_vertexTextureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_vertex_texture);
+	glActiveTexture(GL_TEXTURE0 + g_indexTextureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_index_texture);
+	glActiveTexture(GL_TEXTURE0);
+}
 
-	// Unbind VAO
+// one vertex per corner, the wireframe shader fetches it from the buffer textures
+void Mesh::draw_wireframe() const
+{
+	bind_buffer_textures();
+	glBindVertexArray(m_wireframe_vao);
+	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(m_geom.m_index.size()));
 	glBindVertexArray(0);
 }
 
-void Mesh::get_neighboring_faces(int vertex_id, std::vector<int>& neighbors)
+// position and principal directions of every iStride-th vertex as per instance attributes, the glyph VAO must be bound
+void Mesh::bind_glyph_buffer(GLuint iVbo, int iStride)
 {
-	for (int i = 0; i < m_geom.m_face.size(); ++i)
+	glBindBuffer(GL_ARRAY_BUFFER, iVbo);
+	GLsizei stride = iStride * sizeof(PackedVertex);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, m_position));
+	glVertexAttribPointer(6, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, m_t1));
+	glVertexAttribPointer(7, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, m_t2));
+	for (GLuint location : { 0, 6, 7 })
 	{
-		int idv0 = m_geom.m_face[i].x;
-		int idv1 = m_geom.m_face[i].y;
-		int idv2 = m_geom.m_face[i].z;
-
-		if (vertex_id == idv0 || vertex_id == idv1 || vertex_id == idv2)
-		{
-			neighbors.push_back(i);
-		}
+		glVertexAttribDivisor(location, 1);
+		glEnableVertexAttribArray(location);
 	}
 }
 
-void Mesh::get_neighbors(int vertex_id, std::vector<int>& neighboring_vertices, std::vector<int>& neighboring_faces)
+// T1 and T2 line glyphs in one instanced draw, a stride above 1 subsamples the vertices
+void Mesh::draw_glyphs(bool iT1, bool iT2, int iStride)
 {
-	get_neighboring_faces(vertex_id, neighboring_faces);
-	for (int& f : neighboring_faces)
-	{
-		int idv0 = m_geom.m_face[f].x;
-		int idv1 = m_geom.m_face[f].y;
-		int idv2 = m_geom.m_face[f].z;
+	if (!iT1 && !iT2) { return; }
 
-		if (vertex_id == idv0)
-		{
-			if (std::find(neighboring_vertices.begin(), neighboring_vertices.end(), idv1) == neighboring_vertices.end()) {
-				neighboring_vertices.push_back(idv1);
-			}
-			if (std::find(neighboring_vertices.begin(), neighboring_vertices.end(), idv2) == neighboring_vertices.end()) {
-				neighboring_vertices.push_back(idv2);
-			}
-		}
-		else if (vertex_id == idv1)
-		{
-			if (std::find(neighboring_vertices.begin(), neighboring_vertices.end(), idv0) == neighboring_vertices.end()) {
-				neighboring_vertices.push_back(idv0);
-			}
-			if (std::find(neighboring_vertices.begin(), neighboring_vertices.end(), idv2) == neighboring_vertices.end()) {
-				neighboring_vertices.push_back(idv2);
-			}
-		}
-		else if (vertex_id == idv2)
-		{
-			if (std::find(neighboring_vertices.begin(), neighboring_vertices.end(), idv0) == neighboring_vertices.end()) {
-				neighboring_vertices.push_back(idv0);
-			}
-			if (std::find(neighboring_vertices.begin(), neighboring_vertices.end(), idv1) == neighboring_vertices.end()) {
-				neighboring_vertices.push_back(idv1);
-			}
-		}
+	iStride = std::min(std::max(iStride, 1), g_maxGlyphStride);
+	glBindVertexArray(m_glyph_vao);
+	if (iStride != m_glyph_stride)
+	{
+		m_glyph_stride = iStride;
+		bind_glyph_buffer(m_vbo[m_current_vbo], m_glyph_stride);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
+	// vertices 0 and 1 of an instance span T1, 2 and 3 span T2
+	GLsizei instances = static_cast<GLsizei>((m_geom.m_vertex.size() + iStride - 1) / iStride);
+	glDrawArraysInstanced(GL_LINES, iT1 ? 0 : 2, (iT1 && iT2) ? 4 : 2, instances);
+	glBindVertexArray(0);
 }
 
-void Mesh::taubin_smoothing()
+// extracts the lines seen from iViewPosition, in object space, and uploads them. The silhouettes
+// are the mesh edges between front and back faces, or the smooth zero set of the vertex n.v
+bool ContourLineInputs::operator==(ContourLineInputs const& iOther) const
+{
+	return m_mesh_version == iOther.m_mesh_version && m_view_position == iOther.m_view_position &&
+		m_suggestive == iOther.m_suggestive && m_options.m_min_derivative == iOther.m_options.m_min_derivative &&
+		m_options.m_min_angle == iOther.m_options.m_min_angle && m_silhouettes == iOther.m_silhouettes &&
+		m_edge_silhouettes == iOther.m_edge_silhouettes;
+}
+
+void Mesh::update_contour_lines(glm::vec3 const& iViewPosition, bool iSuggestive, SuggestiveContourOptions const& iOptions, bool iSilhouettes, bool iEdgeSilhouettes)
 {
-	Eigen::MatrixXd Kn = m_geom.transfer_function(m_geom.m_K);
-	Eigen::MatrixXd x = Eigen::MatrixXd::Zero(m_geom.m_vertex.size(), 3);
-	for (size_t i = 0; i < m_geom.m_vertex.size(); ++i)
+	ContourLineInputs inputs;
+	inputs.m_mesh_version = m_version;
+	inputs.m_view_position = iViewPosition;
+	inputs.m_suggestive = iSuggestive;
+	inputs.m_options = iOptions;
+	inputs.m_silhouettes = iSilhouettes;
+	inputs.m_edge_silhouettes = iEdgeSilhouettes;
+	if (m_has_contour_lines && inputs == m_contour_inputs) { return; }
+	m_has_contour_lines = true;
+	m_contour_inputs = inputs;
+
+	m_contour_segment.clear();
+	m_silhouette_edge.clear();
+	m_silhouette_smooth.clear();
+	if (iSuggestive) { m_contours.extract(ThreadPool::global(), iViewPosition, iOptions, m_contour_segment); }
+	if (iSilhouettes) { m_silhouettes.extract(ThreadPool::global(), iViewPosition, iEdgeSilhouettes ? SF_EDGE : SF_SMOOTH, m_silhouette_edge, m_silhouette_smooth); }
+	std::vector<glm::vec3> const& silhouette = iEdgeSilhouettes ? m_silhouette_edge : m_silhouette_smooth;
+
+	// the buffer only grows, with some headroom as the line count changes from one view to the next
+	size_t suggestive_size = m_contour_segment.size() * sizeof(glm::vec3);
+	size_t silhouette_size = silhouette.size() * sizeof(glm::vec3);
+	m_contour_vertex_count = static_cast<GLsizei>(m_contour_segment.size() + silhouette.size());
+	glBindBuffer(GL_ARRAY_BUFFER, m_contour_vbo);
+	if (suggestive_size + silhouette_size > m_contour_capacity)
 	{
-		glm::vec3 v = m_geom.m_vertex[i];
-		x(i, 0) = v.x;
-		x(i, 1) = v.y;
-		x(i, 2) = v.z;
+		m_contour_capacity = (suggestive_size + silhouette_size) * 3 / 2;
+		glBufferData(GL_ARRAY_BUFFER, m_contour_capacity, nullptr, GL_DYNAMIC_DRAW);
 	}
-	Eigen::MatrixXd x_prime = Kn * x;
-	for (size_t i = 0; i < m_geom.m_vertex.size(); ++i)
+	glBufferSubData(GL_ARRAY_BUFFER, 0, suggestive_size, m_contour_segment.data());
+	glBufferSubData(GL_ARRAY_BUFFER, suggestive_size, silhouette_size, silhouette.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::draw_contour_lines() const
+{
+	if (m_contour_vertex_count == 0) { return; }
+
+	glBindVertexArray(m_contour_vao);
+	glDrawArrays(GL_LINES, 0, m_contour_vertex_count);
+	glBindVertexArray(0);
+}
+
+// attributes of a PackedVertex buffer, the VAO must be bound
+void Mesh::bind_vertex_buffer(GLuint iVbo)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, iVbo);
+	GLsizei stride = sizeof(PackedVertex);
+	// position
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, m_position));
+	glEnableVertexAttribArray(0);
+	// octahedral normal
+	glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, m_normal));
+	glEnableVertexAttribArray(1);
+	// octahedral tangent plane U, V is rebuilt by the shaders
+	glVertexAttribPointer(2, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, m_tangent_u));
+	glEnableVertexAttribArray(2);
+	// K1 and K2 principal curvatures
+	glVertexAttribPointer(4, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, m_K));
+	glEnableVertexAttribArray(4);
+	// octahedral T1 and T2 principal directions
+	glVertexAttribPointer(6, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, m_t1));
+	glEnableVertexAttribArray(6);
+	glVertexAttribPointer(7, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, m_t2));
+	glEnableVertexAttribArray(7);
+	// a, b, c, d coefficients of the C tensor
+	glVertexAttribPointer(8, 4, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, m_C));
+	glEnableVertexAttribArray(8);
+}
+
+bool Geometry::load(std::string const& iPath, ThreadPool& iPool)
+{
+	std::string error;
+	if (!load_mesh_file(iPath, iPool, m_vertex, m_face, m_index, error))
 	{
-		m_geom.m_vertex[i].x = x_prime(i, 0);
-		m_geom.m_vertex[i].y = x_prime(i, 1);
-		m_geom.m_vertex[i].z = x_prime(i, 2);
+		std::cerr << "ERROR: " << iPath << " : " << error << std::endl;
+		m_vertex.clear();
+		m_face.clear();
+		m_index.clear();
+		return false;
 	}
+	return true;
+}
 
-	for (size_t i = 0; i < m_geom.m_index.size(); i += 3)
-	{
-		int v0 = m_geom.m_index[i];
-		int v1 = m_geom.m_index[i + 1];
-		int v2 = m_geom.m_index[i + 2];
+void Geometry::cleanup(ThreadPool& iPool, CleanupOptions const& iOptions)
+{
+	if (!iOptions.m_weld && !iOptions.m_cull_faces) { return; }
+
+	CleanupReport report;
+	cleanup_mesh(iPool, iOptions, m_vertex, m_face, m_index, report);
+	std::cout << "cleanup : " << report.m_welded_vertices << " welded and " << report.m_unused_vertices << " unused vertices removed, "
+		<< report.m_degenerate_faces << " degenerate and " << report.m_duplicate_faces << " duplicate faces removed" << std::endl;
+}
+
+void Geometry::reorder(ThreadPool& iPool)
+{
+	reorder_mesh(iPool, m_vertex, m_face, m_index);
+}
+
+void Geometry::optimize_draw_order()
+{
+	DrawOrderReport report;
+	double before = average_cache_miss_ratio(m_index, m_vertex.size());
+	::optimize_draw_order(m_vertex, m_face, m_index, report);
+	std::cout << "draw order : ACMR " << before << " -> " << average_cache_miss_ratio(m_index, m_vertex.size()) << ", " << report.m_clusters << " clusters" << std::endl;
+}
 
-		// compute face normal
-		glm::vec3 e0 = m_geom.m_vertex[v1] - m_geom.m_vertex[v0];
-		glm::vec3 e1 = m_geom.m_vertex[v2] - m_geom.m_vertex[v0];
-		glm::vec3 normal = glm::normalize(glm::cross(e0, e1));
-		m_geom.m_face_normal[i / 3] = normal;
+// CPU side copy of cached streams. Per face data is left empty,
+// compute_curvatures rebuilds it when the positions change
+void Geometry::load_streams(VertexStreams const& iStreams)
+{
+	size_t count = iStreams.m_vertex_count;
+	m_vertex.assign(iStreams.m_position, iStreams.m_position + count);
+	m_vertex_normal.assign(iStreams.m_normal, iStreams.m_normal + count);
+	m_K1.assign(iStreams.m_K1, iStreams.m_K1 + count);
+	m_K2.assign(iStreams.m_K2, iStreams.m_K2 + count);
+	m_t1.assign(iStreams.m_t1, iStreams.m_t1 + count);
+	m_t2.assign(iStreams.m_t2, iStreams.m_t2 + count);
+	m_vertex_coordSys.resize(count);
+	m_vertex_C.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_vertex_coordSys[i].m_u = iStreams.m_tangent_u[i];
+		m_vertex_coordSys[i].m_v = iStreams.m_tangent_v[i];
+		m_vertex_coordSys[i].m_w = iStreams.m_normal[i];
+		m_vertex_C[i].m_a = iStreams.m_C1[i];
+		m_vertex_C[i].m_b = iStreams.m_C2[i];
 	}
 
-	// compute vertex normal
-	for (size_t i = 0; i < m_geom.m_vertex.size(); ++i)
+	m_index.assign(iStreams.m_index, iStreams.m_index + iStreams.m_index_count);
+	m_face.resize(m_index.size() / 3);
+	for (size_t f = 0; f < m_face.size(); ++f)
 	{
-		std::vector<int> neighboring_faces;
-		std::vector<int> neighboring_vertices;
-		get_neighbors(i, neighboring_vertices, neighboring_faces);
+		m_face[f] = glm::ivec3(m_index[3 * f], m_index[3 * f + 1], m_index[3 * f + 2]);
+	}
 
-		glm::vec3 vertex_normal(0.0f, 0.0f, 0.0f);
-		for (int const& face_idx : m_geom.m_neighboring_faces[i])
-		{
-			glm::vec3 face_normal = m_geom.m_face_normal[face_idx];
-			vertex_normal += face_normal;
-		}
-		vertex_normal = glm::normalize(vertex_normal);
+	compute_min_max();
+}
 
-		m_geom.m_vertex_normal[i] = vertex_normal;
-	}
+// every stage is either per face or a gather over the corners of each vertex :
+// elements are computed independently, so the results do not depend on the thread count
+void Geometry::compute_curvatures(ThreadPool& iPool)
+{
+	m_face_normal.resize(m_face.size());
+	m_vertex_normal.resize(m_vertex.size());
+	m_face_coordSys.resize(m_face.size());
+	m_face_weingarten.resize(m_face.size());
+	m_face_weingarten_weights.resize(m_face.size());
+	m_vertex_coordSys.resize(m_vertex.size());
+	m_vertex_weingarten.resize(m_vertex.size());
+	m_t1.resize(m_vertex.size());
+	m_t2.resize(m_vertex.size());
+	m_K1.resize(m_vertex.size());
+	m_K2.resize(m_vertex.size());
+	m_face_C.resize(m_face.size());
+	m_vertex_C.resize(m_vertex.size());
+
+	compute_normals(iPool);
 
 	// compute per face weingarten's matrix
-	m_geom.compute_per_face_weingarten_matrix();
+	compute_per_face_weingarten_matrix(iPool);
 
 	// compute per vertex weingarten's matrix
-	m_geom.compute_per_vertex_weingarten_matrix();
+	compute_per_vertex_weingarten_matrix(iPool);
 
 	// compute min & max (Kg & H)
-	m_geom.m_minKg = 0.0f;
-	m_geom.m_maxKg = 0.0f;
-	m_geom.m_minH = 0.0f;
-	m_geom.m_maxH = 0.0f;
-	m_geom.compute_min_max();
+	m_minKg = 0.0f;
+	m_maxKg = 0.0f;
+	m_minH = 0.0f;
+	m_maxH = 0.0f;
+	compute_min_max();
 
 	// compute C matrix
-	m_geom.compute_per_face_C();
-	m_geom.compute_per_vertex_C();
+	compute_per_face_C(iPool);
+	compute_per_vertex_C(iPool);
+}
 
-	glBindVertexArray(m_vao);
-	update_pos_vbo();
-	update_normal_vbo();
-	update_curvature_vbos();
-	glBindVertexArray(0);
+void Geometry::compute_normals(ThreadPool& iPool)
+{
+	// compute face normal
+	iPool.parallel_for(0, m_face.size(), g_geometryGrain, [this](size_t iBegin, size_t iEnd)
+	{
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			glm::ivec3 const& f = m_face[i];
+			glm::vec3 e0 = m_vertex[f.y] - m_vertex[f.x];
+			glm::vec3 e1 = m_vertex[f.z] - m_vertex[f.x];
+			m_face_normal[i] = glm::normalize(glm::cross(e0, e1));
+		}
+	});
+
+	// compute vertex normal
+	iPool.parallel_for(0, m_vertex.size(), g_geometryGrain, [this](size_t iBegin, size_t iEnd)
+	{
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			glm::vec3 vertex_normal(0.0f, 0.0f, 0.0f);
+			for (int const& c : m_corners.corners(i))
+			{
+				if (m_corners.repeats_vertex(c)) { continue; }
+				vertex_normal += m_face_normal[CornerTable::face(c)];
+			}
+			m_vertex_normal[i] = glm::normalize(vertex_normal);
+		}
+	});
+}
+
+void Geometry::compute_adjacency()
+{
+	size_t vertex_count = m_vertex.size();
+	m_corners.build(m_face, vertex_count);
+
+	// vertex -> vertices : walk the faces around each vertex in face order and store
+	// their other vertices in face order, the first-seen order of the former linear scan.
+	// last_visitor[j] == i marks j as already stored in the one-ring of i
+	std::vector<int> last_visitor(vertex_count, -1);
+	m_vertex_vertices.m_offset.resize(vertex_count + 1);
+	m_vertex_vertices.m_offset[0] = 0;
+	m_vertex_vertices.m_index.clear();
+	m_vertex_vertices.m_index.reserve(2 * m_corners.m_corner_vertex.size());
+	for (size_t i = 0; i < vertex_count; ++i)
+	{
+		for (int const& c : m_corners.corners(i))
+		{
+			int first = 3 * CornerTable::face(c);
+			for (int k = first; k < first + 3; ++k)
+			{
+				int j = m_corners.vertex(k);
+				if (j != static_cast<int>(i) && last_visitor[j] != static_cast<int>(i))
+				{
+					last_visitor[j] = i;
+					m_vertex_vertices.m_index.push_back(j);
+				}
+			}
+		}
+		m_vertex_vertices.m_offset[i + 1] = m_vertex_vertices.m_index.size();
+	}
+}
+
+void Mesh::taubin_smoothing()
+{
+	m_geom.apply_taubin_filter();
+	m_geom.compute_curvatures(ThreadPool::global());
+
+	update_vbo();
+	++m_version;
+	GeometryStreams streams(m_geom);
+	m_contours.build(ThreadPool::global(), streams.m_streams);
+	m_silhouettes.build(m_geom.m_vertex, m_geom.m_vertex_normal, m_geom.m_corners);
 }
 
 void Geometry::compute_circulant_matrix()
 {
+	// W only holds the one-ring of each vertex
 	size_t dimension = m_vertex.size();
-	m_W = Eigen::MatrixXd::Zero(dimension, dimension);
-	m_K = Eigen::MatrixXd::Identity(dimension, dimension);
+	std::vector<Eigen::Triplet<float>> w_entries;
+	w_entries.reserve(m_vertex_vertices.m_index.size());
 
 	for (size_t i = 0; i < dimension; ++i)
 	{
 		glm::vec3 const& vi = m_vertex[i];
-		std::vector<int> const& neighbors_of_i = m_neighboring_vertices[i];
+		IndexRange neighbors_of_i = m_vertex_vertices[i];
 		
 		float sum_phi_vi_vj = 0.0f;
 		for (int const& j : neighbors_of_i)
@@ -370,10 +579,12 @@ void Geometry::compute_circulant_matrix()
 		for (int const& j : neighbors_of_i)
 		{
 			glm::vec3 const& vj = m_vertex[j];
-			m_W(i, j) = phi(vi, vj) / sum_phi_vi_vj;
-			m_K(i, j) -= m_W(i, j);
+			w_entries.emplace_back(i, j, phi(vi, vj) / sum_phi_vi_vj);
 		}
 	}
+
+	m_W.resize(dimension, dimension);
+	m_W.setFromTriplets(w_entries.begin(), w_entries.end());
 }
 
 float Geometry::phi(glm::vec3 vi, glm::vec3 vj)
@@ -384,184 +595,139 @@ float Geometry::phi(glm::vec3 vi, glm::vec3 vj)
 	return pow(norm, alpha);
 }
 
-Eigen::MatrixXd Geometry::transfer_function(Eigen::MatrixXd& m)
-{
-	Eigen::MatrixXd I = Eigen::MatrixXd::Identity(m_vertex.size(), m_vertex.size());
-	Eigen::MatrixXd res = (I - (lambda * m)) * (I - (mu * m));
-	Eigen::MatrixXd resPow(res.pow(N));
-	return resPow;
-}
-
-void Mesh::update_pos_vbo()
+// low-pass filter f(K) = ((I - mu K)(I - lambda K))^N applied to the positions
+// as N alternating lambda (shrinking) and mu (inflating) passes
+void Geometry::apply_taubin_filter()
 {
-	glBindBuffer(GL_ARRAY_BUFFER, m_posvbo);
-	void* data = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	float* vertex_pos = reinterpret_cast<float*>(data);
-	for (size_t i = 0; i < m_geom.m_vertex.size(); ++i)
+	// W depends on the positions at load time, built on first use
+	if (m_W.rows() != static_cast<Eigen::Index>(m_vertex.size()))
 	{
-		glm::vec3 v = m_geom.m_vertex[i];
-		vertex_pos[3 * i] = v.x;
-		vertex_pos[3 * i + 1] = v.y;
-		vertex_pos[3 * i + 2] = v.z;
+		compute_circulant_matrix();
 	}
-	glUnmapBuffer(GL_ARRAY_BUFFER);
+	taubin_smoothing_kernel(ThreadPool::global(), m_W, lambda, mu, N, m_vertex);
 }
 
-void Mesh::update_normal_vbo()
+// every attribute moves with the positions : the pipeline results are packed straight into
+// the buffer that is not drawn from, without syncing with the GPU, then the buffers are swapped
+void Mesh::update_vbo()
 {
-	glBindBuffer(GL_ARRAY_BUFFER, m_normalvbo);
-	void* data = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	float* vertex_normal = reinterpret_cast<float*>(data);
-	for (size_t i = 0; i < m_geom.m_vertex_normal.size(); ++i)
+	size_t size = m_geom.m_vertex.size() * sizeof(PackedVertex);
+	int next = 1 - m_current_vbo;
+	if (m_vbo[next] == 0)
 	{
-		glm::vec3 n = m_geom.m_vertex_normal[i];
-		vertex_normal[3 * i] = n.x;
-		vertex_normal[3 * i + 1] = n.y;
-		vertex_normal[3 * i + 2] = n.z;
+		glGenBuffers(1, &m_vbo[next]);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vbo[next]);
+		glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
 	}
-	glUnmapBuffer(GL_ARRAY_BUFFER);
-}
-
-void Mesh::update_curvature_vbos()
-{
-	glBindBuffer(GL_ARRAY_BUFFER, m_K1Vbo);
-	void* data = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	float* K1 = reinterpret_cast<float*>(data);
-	for (size_t i = 0; i < m_geom.m_K1.size(); ++i)
+	if (m_vbo_fence[next] != nullptr)
 	{
-		float k = m_geom.m_K1[i];
-		K1[i] = k;
+		// frames are drawn between two updates, so the draws from that buffer are usually done
+		GLenum status;
+		do
+		{
+			status = glClientWaitSync(m_vbo_fence[next], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(m_vbo_fence[next]);
+		m_vbo_fence[next] = nullptr;
 	}
-	glUnmapBuffer(GL_ARRAY_BUFFER);
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_K2Vbo);
-	data = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	float* K2 = reinterpret_cast<float*>(data);
-	for (size_t i = 0; i < m_geom.m_K2.size(); ++i)
-	{
-		float k = m_geom.m_K2[i];
-		K2[i] = k;
-	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_vbo[next]);
+	PackedVertex* vertices = reinterpret_cast<PackedVertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	m_geom.pack_vertices(ThreadPool::global(), vertices);
 	glUnmapBuffer(GL_ARRAY_BUFFER);
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_T1Vbo);
-	data = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	float* T1 = reinterpret_cast<float*>(data);
-	for (size_t i = 0; i < m_geom.m_t1.size(); ++i)
-	{
-		glm::vec3 t = m_geom.m_t1[i];
-		T1[i * 3] = t.x;
-		T1[i * 3 + 1] = t.y;
-		T1[i * 3 + 2] = t.z;
-	}
-	glUnmapBuffer(GL_ARRAY_BUFFER);
+	// no draw reads the current buffer after this fence
+	m_vbo_fence[m_current_vbo] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_current_vbo = next;
+	glBindVertexArray(m_vao);
+	bind_vertex_buffer(m_vbo[m_current_vbo]);
+	glBindVertexArray(m_glyph_vao);
+	bind_glyph_buffer(m_vbo[m_current_vbo], m_glyph_stride);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_BUFFER, m_vertex_texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, m_vbo[m_current_vbo]);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_T2Vbo);
-	data = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	float* T2 = reinterpret_cast<float*>(data);
-	for (size_t i = 0; i < m_geom.m_t2.size(); ++i)
+void Geometry::pack_vertices(ThreadPool& iPool, PackedVertex* oVertex) const
+{
+	iPool.parallel_for(0, m_vertex.size(), g_geometryGrain, [&](size_t iBegin, size_t iEnd)
 	{
-		glm::vec3 t = m_geom.m_t2[i];
-		T2[i * 3] = t.x;
-		T2[i * 3 + 1] = t.y;
-		T2[i * 3 + 2] = t.z;
-	}
-	glUnmapBuffer(GL_ARRAY_BUFFER);
-
-	std::vector<glm::mat2> C1;
-	for (auto const& m : m_geom.m_vertex_C) { C1.push_back(m.m_a); }
-	glBindBuffer(GL_ARRAY_BUFFER, m_C1Vbo);
-	data = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	float* c1 = reinterpret_cast<float*>(data);
-	for (size_t i = 0; i < C1.size(); ++i)
-	{
-		glm::mat2 m = C1[i];
-		const float* m_array = reinterpret_cast<const float*>(glm::value_ptr(m));
-		c1[i * 4] = m_array[0];
-		c1[i * 4 + 1] = m_array[1];
-		c1[i * 4 + 2] = m_array[2];
-		c1[i * 4 + 3] = m_array[3];
-	}
-	glUnmapBuffer(GL_ARRAY_BUFFER);
-
-	std::vector<glm::mat2> C2;
-	for (auto const& m : m_geom.m_vertex_C) { C2.push_back(m.m_b); }
-	glBindBuffer(GL_ARRAY_BUFFER, m_C2Vbo);
-	data = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-	float* c2 = reinterpret_cast<float*>(data);
-	for (size_t i = 0; i < C2.size(); ++i)
-	{
-		glm::mat2 m = C2[i];
-		const float* m_array = reinterpret_cast<const float*>(glm::value_ptr(m));
-		c2[i * 4] = m_array[0];
-		c2[i * 4 + 1] = m_array[1];
-		c2[i * 4 + 2] = m_array[2];
-		c2[i * 4 + 3] = m_array[3];
-	}
-	glUnmapBuffer(GL_ARRAY_BUFFER);
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			oVertex[i] = pack_vertex(m_vertex[i], m_vertex_normal[i], m_vertex_coordSys[i].m_u, m_t1[i], m_t2[i],
+				m_K1[i], m_K2[i], m_vertex_C[i].m_a, m_vertex_C[i].m_b);
+		}
+	});
 }
 
-void Geometry::compute_per_face_weingarten_matrix()
-{
-	m_face_coordSys.clear();
-	m_face_weingarten.clear();
-	m_face_weingarten_weights.clear();
-
-	for (size_t i = 0; i < m_face.size(); ++i)
-	{
-		int idv0 = m_face[i].x;
-		int idv1 = m_face[i].y;
-		int idv2 = m_face[i].z;
-
-		// get face vertices and per vertex normals
-		glm::vec3 v0 = m_vertex[idv0];
-		glm::vec3 n0 = m_vertex_normal[idv0];
-		glm::vec3 v1 = m_vertex[idv1];
-		glm::vec3 n1 = m_vertex_normal[idv1];
-		glm::vec3 v2 = m_vertex[idv2];
-		glm::vec3 n2 = m_vertex_normal[idv2];
-
-		// compute edges
-		glm::vec3 e0 = v1 - v0;
-		glm::vec3 e1 = v2 - v1;
-		glm::vec3 e2 = v0 - v2;
-
-		// compute face's coordinate system
-		struct CoordSys cs;
-		cs.m_u = glm::normalize(e0);
-		cs.m_v = glm::normalize(glm::cross(cs.m_u, glm::cross(e1, -e0)));
-		cs.m_w = glm::normalize(glm::cross(e1, -e0));
-		m_face_coordSys.push_back(cs);
-
-		// solve curvature tensor matrix by using linear least squares
-		Eigen::MatrixXf A = Eigen::MatrixXf::Zero(6, 4);
-		A(0, 0) = glm::dot(e0, cs.m_u); A(0, 1) = glm::dot(e0, cs.m_v);
-		A(1, 2) = glm::dot(e0, cs.m_u); A(1, 3) = glm::dot(e0, cs.m_v);
-		A(2, 0) = glm::dot(e1, cs.m_u); A(2, 1) = glm::dot(e1, cs.m_v);
-		A(3, 2) = glm::dot(e1, cs.m_u); A(3, 3) = glm::dot(e1, cs.m_v);
-		A(4, 0) = glm::dot(e2, cs.m_u); A(4, 1) = glm::dot(e2, cs.m_v);
-		A(5, 2) = glm::dot(e2, cs.m_u); A(5, 3) = glm::dot(e2, cs.m_v);
-
-		Eigen::MatrixXf b = Eigen::MatrixXf::Zero(6, 1);
-		b(0, 0) = glm::dot((n1 - n0), cs.m_u);
-		b(1, 0) = glm::dot((n1 - n0), cs.m_v);
-		b(2, 0) = glm::dot((n2 - n1), cs.m_u);
-		b(3, 0) = glm::dot((n2 - n1), cs.m_v);
-		b(4, 0) = glm::dot((n0 - n2), cs.m_u);
-		b(5, 0) = glm::dot((n0 - n2), cs.m_v);
-
-		Eigen::Vector4f x = A.colPivHouseholderQr().solve(b);
-
-		glm::mat2 m;
-		m[0][0] = x(0); m[0][1] = x(1);
-		m[1][0] = x(2); m[1][1] = x(3);
-		m_face_weingarten.push_back(m);
+void Geometry::compute_per_face_weingarten_matrix(ThreadPool& iPool)
+{
+	iPool.parallel_for(0, m_face.size(), g_geometryGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			int idv0 = m_face[i].x;
+			int idv1 = m_face[i].y;
+			int idv2 = m_face[i].z;
+
+			// get face vertices and per vertex normals
+			glm::vec3 v0 = m_vertex[idv0];
+			glm::vec3 n0 = m_vertex_normal[idv0];
+			glm::vec3 v1 = m_vertex[idv1];
+			glm::vec3 n1 = m_vertex_normal[idv1];
+			glm::vec3 v2 = m_vertex[idv2];
+			glm::vec3 n2 = m_vertex_normal[idv2];
+
+			// compute edges
+			glm::vec3 e0 = v1 - v0;
+			glm::vec3 e1 = v2 - v1;
+			glm::vec3 e2 = v0 - v2;
+
+			// compute face's coordinate system
+			struct CoordSys cs;
+			cs.m_u = glm::normalize(e0);
+			cs.m_v = glm::normalize(glm::cross(cs.m_u, glm::cross(e1, -e0)));
+			cs.m_w = glm::normalize(glm::cross(e1, -e0));
+			m_face_coordSys[i] = cs;
+
+			// solve curvature tensor matrix by using linear least squares :
+			// the 6x4 system splits into two 2x2 normal equations sharing the matrix
+			// M = sum(e e^T), e being the edges expressed in the face coordinate system
+			glm::vec3 const edges[3] = { e0, e1, e2 };
+			glm::vec3 const normal_variations[3] = { n1 - n0, n2 - n1, n0 - n2 };
+			float m00 = 0.0f;
+			float m01 = 0.0f;
+			float m11 = 0.0f;
+			glm::vec2 rhs_u(0.0f);
+			glm::vec2 rhs_v(0.0f);
+			for (int k = 0; k < 3; ++k)
+			{
+				glm::vec2 e(glm::dot(edges[k], cs.m_u), glm::dot(edges[k], cs.m_v));
+				m00 += e.x * e.x;
+				m01 += e.x * e.y;
+				m11 += e.y * e.y;
+				rhs_u += e * glm::dot(normal_variations[k], cs.m_u);
+				rhs_v += e * glm::dot(normal_variations[k], cs.m_v);
+			}
+
+			glm::mat2 m(0.0f);
+			float det = m00 * m11 - m01 * m01;
+			if (det != 0.0f)
+			{
+				float inv_det = 1.0f / det;
+				m[0][0] = (m11 * rhs_u.x - m01 * rhs_u.y) * inv_det; m[0][1] = (m00 * rhs_u.y - m01 * rhs_u.x) * inv_det;
+				m[1][0] = (m11 * rhs_v.x - m01 * rhs_v.y) * inv_det; m[1][1] = (m00 * rhs_v.y - m01 * rhs_v.x) * inv_det;
+			}
+			m_face_weingarten[i] = m;
 		
-		// compute the curvature tensor weights for each of its vertices
-		glm::vec3 weights;
-		compute_face_mixed_voronoi_area(v0, v1, v2, weights);
-		m_face_weingarten_weights.push_back(weights);
-	}
+			// compute the curvature tensor weights for each of its vertices
+			glm::vec3 weights;
+			compute_face_mixed_voronoi_area(v0, v1, v2, weights);
+			m_face_weingarten_weights[i] = weights;
+		}
+	});
 }
 
 void Geometry::compute_face_mixed_voronoi_area(glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c, glm::vec3& weights)
@@ -609,140 +775,142 @@ void Geometry::compute_face_mixed_voronoi_area(glm::vec3 const& a, glm::vec3 con
 	}
 }
 
-void Geometry::compute_per_vertex_weingarten_matrix()
+void Geometry::compute_per_vertex_weingarten_matrix(ThreadPool& iPool)
 {
-	m_vertex_coordSys.clear();
-	m_vertex_weingarten.clear();
-	glm::mat2 init{ 0.0f, 0.0f, 0.0f, 0.0f };
-	m_vertex_weingarten.assign(m_vertex.size(), init);
-
-	for (size_t i = 0; i < m_vertex.size(); ++i)
+	iPool.parallel_for(0, m_vertex.size(), g_geometryGrain, [&](size_t iBegin, size_t iEnd)
 	{
-		glm::vec3 const& x = m_vertex[i];
-		glm::vec3 const& n = m_vertex_normal[i];
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			glm::vec3 const& n = m_vertex_normal[i];
 
-		// build vertex coordinate system
-		float d = glm::dot(n, x);
-		float randX = gen_random(0.05f, 0.95f);
-		float randY = gen_random(0.05f, 0.95f);
-		glm::vec3 u(randX, randY, 0.0f);
-		u.z = (-(n.x * u.x + n.y * u.y) + d) / n.z;
-		u = glm::normalize(u);
-		glm::vec3 v = glm::normalize(glm::cross(n, u));
+			// build vertex coordinate system
+			glm::vec3 u;
+			glm::vec3 v;
+			orthonormal_basis(n, u, v);
 
-		struct CoordSys vertex_cs;
-		vertex_cs.m_u = u;
-		vertex_cs.m_v = v;
-		vertex_cs.m_w = n;
-		m_vertex_coordSys.push_back(vertex_cs);
+			struct CoordSys vertex_cs;
+			vertex_cs.m_u = u;
+			vertex_cs.m_v = v;
+			vertex_cs.m_w = n;
+			m_vertex_coordSys[i] = vertex_cs;
+			m_vertex_weingarten[i] = glm::mat2(0.0f);
 
-		// express curvature tensor of all surrounding faces
-		// in terms of the current vertex coordinate system
-		std::vector<int> const& neighboring_faces = m_neighboring_faces[i];
-		float sum_weights = 0.0f;
+			// express curvature tensor of all surrounding faces
+			// in terms of the current vertex coordinate system
+			float sum_weights = 0.0f;
 
-		for (int const& fIdx : neighboring_faces)
-		{
-			glm::ivec3 face = m_face[fIdx];
-			struct CoordSys const& face_coordSys = m_face_coordSys[fIdx];
-			glm::vec3 const& face_normal = face_coordSys.m_w;
-
-			// get face voronoi area weight associated to current vertex
-			glm::vec3 weights = m_face_weingarten_weights[fIdx];
-			float weight = 0.0f;
-			if (face.x == i) { weight = weights.x; }
-			else if (face.y == i) { weight = weights.y; }
-			else { weight = weights.z; }
-			sum_weights += weight;
-
-			// get curvature tensor of face, and vector quantities of the vertex and face's coordinate systems
-			glm::mat2 const& curvatureTensor = m_face_weingarten[fIdx];
-			glm::vec3 Up = vertex_cs.m_u;
-			glm::vec3 Vp = vertex_cs.m_v;
-			glm::vec3 Uf = face_coordSys.m_u;
-			glm::vec3 Vf = face_coordSys.m_v;
-
-			// check if normals are parallel (compute rotation or not ?)
-			float cos_normals = glm::dot(face_normal, n);
-			if (cos_normals > 0.998f) // parallel => no rotation
+			for (int const& c : m_corners.corners(i))
 			{
-				// now get curvature tensor
-				// in this new coordinate system (Uf, Vf) : vertex coordinate system expressed in face's one
-				float UpUf = glm::dot(Up, Uf);
-				float UpVf = glm::dot(Up, Vf);
-				float VpUf = glm::dot(Vp, Uf);
-				float VpVf = glm::dot(Vp, Vf);
-
-				float ep = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), (curvatureTensor * glm::normalize(glm::vec2(UpUf, UpVf))));
-				float fp = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), (curvatureTensor * glm::normalize(glm::vec2(VpUf, VpVf))));
-				float gp = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), (curvatureTensor * glm::normalize(glm::vec2(VpUf, VpVf))));
-
-				glm::mat2 tensor;
-				tensor[0][0] = ep;
-				tensor[0][1] = fp;
-				tensor[1][0] = fp;
-				tensor[1][1] = gp;
-
-				m_vertex_weingarten[i] += weight * tensor;
-			}
-			else
-			{
-				// axis of rotation for coordinate system transform
-				glm::vec3 axis = glm::cross(face_normal, n);
-				axis = glm::normalize(axis);
-
-				// compute rotation angle from face coordinate system
-				// to the current vertex coordinate system
-				float angle = acos( glm::dot(face_normal, n) / (glm::length(face_normal) * glm::length(n)) );
-				glm::quat q = glm::angleAxis(angle, axis);
+				if (m_corners.repeats_vertex(c)) { continue; }
+				int fIdx = CornerTable::face(c);
+				struct CoordSys const& face_coordSys = m_face_coordSys[fIdx];
+				glm::vec3 const& face_normal = face_coordSys.m_w;
+
+				// get face voronoi area weight associated to current vertex
+				float weight = m_face_weingarten_weights[fIdx][c % 3];
+				sum_weights += weight;
+
+				// get curvature tensor of face, and vector quantities of the vertex and face's coordinate systems
+				glm::mat2 const& curvatureTensor = m_face_weingarten[fIdx];
+				glm::vec3 Up = vertex_cs.m_u;
+				glm::vec3 Vp = vertex_cs.m_v;
+				glm::vec3 Uf = face_coordSys.m_u;
+				glm::vec3 Vf = face_coordSys.m_v;
+
+				// check if normals are parallel (compute rotation or not ?)
+				float cos_normals = glm::dot(face_normal, n);
+				if (cos_normals > 0.998f) // parallel => no rotation
+				{
+					// now get curvature tensor
+					// in this new coordinate system (Uf, Vf) : vertex coordinate system expressed in face's one
+					float UpUf = glm::dot(Up, Uf);
+					float UpVf = glm::dot(Up, Vf);
+					float VpUf = glm::dot(Vp, Uf);
+					float VpVf = glm::dot(Vp, Vf);
+
+					float ep = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), (curvatureTensor * glm::normalize(glm::vec2(UpUf, UpVf))));
+					float fp = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), (curvatureTensor * glm::normalize(glm::vec2(VpUf, VpVf))));
+					float gp = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), (curvatureTensor * glm::normalize(glm::vec2(VpUf, VpVf))));
+
+					glm::mat2 tensor;
+					tensor[0][0] = ep;
+					tensor[0][1] = fp;
+					tensor[1][0] = fp;
+					tensor[1][1] = gp;
+
+					m_vertex_weingarten[i] += weight * tensor;
+				}
+				else
+				{
+					// axis of rotation for coordinate system transform
+					glm::vec3 axis = glm::cross(face_normal, n);
+					axis = glm::normalize(axis);
+
+					// compute rotation angle from face coordinate system
+					// to the current vertex coordinate system
+					float angle = acos( glm::dot(face_normal, n) / (glm::length(face_normal) * glm::length(n)) );
+					glm::quat q = glm::angleAxis(angle, axis);
 				
-				// rotate face coordinate system
-				glm::vec3 face_up = q * face_coordSys.m_u;
-				glm::vec3 face_vp = q * face_coordSys.m_v;
-				glm::vec3 face_wp = q * face_coordSys.m_w;
-
-				// now get curvature tensor
-				// in this new coordinate system (Uf, Vf) : vertex coordinate system expressed in face's one
-				Uf = face_up;
-				Vf = face_vp;
+					// rotate face coordinate system
+					glm::vec3 face_up = q * face_coordSys.m_u;
+					glm::vec3 face_vp = q * face_coordSys.m_v;
+					glm::vec3 face_wp = q * face_coordSys.m_w;
+
+					// now get curvature tensor
+					// in this new coordinate system (Uf, Vf) : vertex coordinate system expressed in face's one
+					Uf = face_up;
+					Vf = face_vp;
 				
-				float UpUf = glm::dot(Up, Uf);
-				float UpVf = glm::dot(Up, Vf);
-				float VpUf = glm::dot(Vp, Uf);
-				float VpVf = glm::dot(Vp, Vf);
-
-				float ep = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), (curvatureTensor * glm::normalize(glm::vec2(UpUf, UpVf))));
-				float fp = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), (curvatureTensor * glm::normalize(glm::vec2(VpUf, VpVf))));
-				float gp = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), (curvatureTensor * glm::normalize(glm::vec2(VpUf, VpVf))));
-
-				glm::mat2 tensor;
-				tensor[0][0] = ep;
-				tensor[0][1] = fp;
-				tensor[1][0] = fp;
-				tensor[1][1] = gp;
-
-				m_vertex_weingarten[i] += weight * tensor;
+					float UpUf = glm::dot(Up, Uf);
+					float UpVf = glm::dot(Up, Vf);
+					float VpUf = glm::dot(Vp, Uf);
+					float VpVf = glm::dot(Vp, Vf);
+
+					float ep = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), (curvatureTensor * glm::normalize(glm::vec2(UpUf, UpVf))));
+					float fp = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), (curvatureTensor * glm::normalize(glm::vec2(VpUf, VpVf))));
+					float gp = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), (curvatureTensor * glm::normalize(glm::vec2(VpUf, VpVf))));
+
+					glm::mat2 tensor;
+					tensor[0][0] = ep;
+					tensor[0][1] = fp;
+					tensor[1][0] = fp;
+					tensor[1][1] = gp;
+
+					m_vertex_weingarten[i] += weight * tensor;
+				}
 			}
+			m_vertex_weingarten[i] /= sum_weights;
 		}
-		m_vertex_weingarten[i] /= sum_weights;
-
-		// compute eigen values and eigen vectors of the curvature tensor
-		Eigen::Matrix2f eigenMat;
-		eigenMat(0, 0) = m_vertex_weingarten[i][0][0];
-		eigenMat(0, 1) = m_vertex_weingarten[i][0][1];
-		eigenMat(1, 0) = m_vertex_weingarten[i][1][0];
-		eigenMat(1, 1) = m_vertex_weingarten[i][1][1];
-
-		Eigen::EigenSolver<Eigen::MatrixXf> solver;
-		solver.compute(eigenMat, true);
-		Eigen::Vector2f eigenValues = solver.eigenvalues().real();
-		Eigen::Matrix2f eigenVectors = solver.eigenvectors().real();
-
-		m_K1[i] = eigenValues(1);
-		m_K2[i] = eigenValues(0);
-		m_t1[i] = glm::normalize(vertex_cs.m_u * eigenVectors.col(1)(0) + vertex_cs.m_v * eigenVectors.col(1)(1));
-		m_t2[i] = glm::normalize(vertex_cs.m_u * eigenVectors.col(0)(0) + vertex_cs.m_v * eigenVectors.col(0)(1));
-	}
+	});
+
+	// principal curvatures and directions from the curvature tensors, in batches.
+	// g_geometryGrain is a multiple of the batch width so every block starts a batch
+	iPool.parallel_for(0, m_vertex.size(), g_geometryGrain, [this](size_t iBegin, size_t iEnd)
+	{
+		size_t count = iEnd - iBegin;
+		// zeroed : the compiler can not see that the batch only reads the first count entries
+		std::array<float, g_geometryGrain> a{};
+		std::array<float, g_geometryGrain> b{};
+		std::array<float, g_geometryGrain> c{};
+		std::array<float, g_geometryGrain> cos_theta;
+		std::array<float, g_geometryGrain> sin_theta;
+		for (size_t k = 0; k < count; ++k)
+		{
+			a[k] = m_vertex_weingarten[iBegin + k][0][0];
+			b[k] = m_vertex_weingarten[iBegin + k][0][1];
+			c[k] = m_vertex_weingarten[iBegin + k][1][1];
+		}
+
+		symmetric_eigen_2x2_batch(count, a.data(), b.data(), c.data(), &m_K1[iBegin], &m_K2[iBegin], cos_theta.data(), sin_theta.data());
+
+		for (size_t k = 0; k < count; ++k)
+		{
+			// t1 = (cos, sin) in the (u, v) frame, t2 = n x t1
+			struct CoordSys const& vertex_cs = m_vertex_coordSys[iBegin + k];
+			m_t1[iBegin + k] = vertex_cs.m_u * cos_theta[k] + vertex_cs.m_v * sin_theta[k];
+			m_t2[iBegin + k] = vertex_cs.m_v * cos_theta[k] - vertex_cs.m_u * sin_theta[k];
+		}
+	});
 }
 
 float triangle_corner_angle(glm::vec3 const& corner, glm::vec3 const& a, glm::vec3 const& b)
@@ -783,16 +951,77 @@ float triangle_area(glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c)
 	return (e1_length * e2_length * sin(theta)) / 2.0;
 }
 
-float gen_random(float from, float to)
+// tangent vectors u, v such that (u, v, n) is a direct orthonormal frame, n being unit length.
+// Depends only on n and stays stable when n.z goes to zero
+// (Duff et al. 2017, "Building an Orthonormal Basis, Revisited")
+void orthonormal_basis(glm::vec3 const& n, glm::vec3& u, glm::vec3& v)
+{
+	float sign = std::copysign(1.0f, n.z);
+	float a = -1.0f / (sign + n.z);
+	float b = n.x * n.y * a;
+	u = glm::vec3(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+	v = glm::vec3(b, sign + n.y * n.y * a, -n.y);
+}
+
+// eigen decomposition of the symmetric matrix [[a, b], [b, c]].
+// k1 = m + r and k2 = m - r with m = (a + c) / 2, r = sqrt(((a - c) / 2)^2 + b^2).
+// The eigenvector of k1 is taken from whichever of (r + d, b) and (b, r - d) avoids
+// the cancellation, d = (a - c) / 2. At an umbilic both vanish and (1, 0) is returned.
+void symmetric_eigen_2x2(float a, float b, float c, float& k1, float& k2, float& cos_theta, float& sin_theta)
 {
-	std::random_device rd;
-	std::mt19937 mt(rd());
-	std::uniform_real_distribution<float> dist(from, to);
-	return dist(mt);
+	float m = 0.5f * (a + c);
+	float d = 0.5f * (a - c);
+	float r = std::sqrt(d * d + b * b);
+	k1 = m + r;
+	k2 = m - r;
+
+	float x = (d >= 0.0f) ? r + d : b;
+	float y = (d >= 0.0f) ? b : r - d;
+	float len = std::sqrt(x * x + y * y);
+	bool valid = len > std::numeric_limits<float>::min();
+	cos_theta = valid ? x / len : 1.0f;
+	sin_theta = valid ? y / len : 0.0f;
+}
+
+// same as symmetric_eigen_2x2 on g_taubinLanes matrices at once, scalar tail
+void symmetric_eigen_2x2_batch(size_t iCount, float const* a, float const* b, float const* c,
+	float* k1, float* k2, float* cos_theta, float* sin_theta)
+{
+	using Lanes = Eigen::Array<float, g_taubinLanes, 1>;
+	using LaneMask = Eigen::Array<bool, g_taubinLanes, 1>;
+
+	size_t i = 0;
+	for (; i + g_taubinLanes <= iCount; i += g_taubinLanes)
+	{
+		Lanes la = Eigen::Map<Lanes const>(a + i);
+		Lanes lb = Eigen::Map<Lanes const>(b + i);
+		Lanes lc = Eigen::Map<Lanes const>(c + i);
+
+		Lanes m = 0.5f * (la + lc);
+		Lanes d = 0.5f * (la - lc);
+		Lanes r = (d * d + lb * lb).sqrt();
+		Eigen::Map<Lanes>(k1 + i) = m + r;
+		Eigen::Map<Lanes>(k2 + i) = m - r;
+
+		LaneMask positive = d >= 0.0f;
+		Lanes x = positive.select(r + d, lb);
+		Lanes y = positive.select(lb, r - d);
+		Lanes len = (x * x + y * y).sqrt();
+		LaneMask valid = len > std::numeric_limits<float>::min();
+		Eigen::Map<Lanes>(cos_theta + i) = valid.select(x / len, Lanes::Constant(1.0f));
+		Eigen::Map<Lanes>(sin_theta + i) = valid.select(y / len, Lanes::Zero());
+	}
+
+	for (; i < iCount; ++i)
+	{
+		symmetric_eigen_2x2(a[i], b[i], c[i], k1[i], k2[i], cos_theta[i], sin_theta[i]);
+	}
 }
 
 void Geometry::compute_min_max()
 {
+	if (m_vertex.empty()) { return; }
+
 	// compute min and max Gaussian curvature
 	m_minKg = m_K1[0] * m_K2[0];
 	m_maxKg = m_K1[0] * m_K2[0];
@@ -814,147 +1043,157 @@ void Geometry::compute_min_max()
 	}
 }
 
-void Geometry::compute_per_face_C()
+void Geometry::compute_per_face_C(ThreadPool& iPool)
 {
-	size_t dimension = m_face.size();
-	for (size_t i = 0; i < dimension; ++i)
+	iPool.parallel_for(0, m_face.size(), g_geometryGrain, [&](size_t iBegin, size_t iEnd)
 	{
-		int idv0 = m_face[i].x;
-		int idv1 = m_face[i].y;
-		int idv2 = m_face[i].z;
-
-		// get edges
-		glm::vec3 e0 = m_vertex[idv1] - m_vertex[idv0];
-		glm::vec3 e1 = m_vertex[idv2] - m_vertex[idv1];
-		glm::vec3 e2 = m_vertex[idv0] - m_vertex[idv2];
-
-		// get all second fundamental form matrices
-		glm::mat2 sff_v0 = m_vertex_weingarten[idv0];
-		glm::mat2 sff_v1 = m_vertex_weingarten[idv1];
-		glm::mat2 sff_v2 = m_vertex_weingarten[idv2];
-
-		// get face coordinate system
-		struct CoordSys cs = m_face_coordSys[i];
-
-		// solve face's C matrix by using linear least squares
-		Eigen::MatrixXf A = Eigen::MatrixXf::Zero(9, 4);
-		A(0, 0) = glm::dot(e0, cs.m_u); A(0, 1) = glm::dot(e0, cs.m_v);
-		A(1, 1) = glm::dot(e0, cs.m_u); A(1, 2) = glm::dot(e0, cs.m_v);
-		A(2, 2) = glm::dot(e0, cs.m_u); A(2, 3) = glm::dot(e0, cs.m_v);
-		A(3, 0) = glm::dot(e1, cs.m_u); A(3, 1) = glm::dot(e1, cs.m_v);
-		A(4, 1) = glm::dot(e1, cs.m_u); A(4, 2) = glm::dot(e1, cs.m_v);
-		A(5, 2) = glm::dot(e1, cs.m_u); A(5, 3) = glm::dot(e1, cs.m_v);
-		A(6, 0) = glm::dot(e2, cs.m_u); A(6, 1) = glm::dot(e2, cs.m_v);
-		A(7, 1) = glm::dot(e2, cs.m_u); A(7, 2) = glm::dot(e2, cs.m_v);
-		A(8, 2) = glm::dot(e2, cs.m_u); A(8, 3) = glm::dot(e2, cs.m_v);
-
-		Eigen::MatrixXf b = Eigen::MatrixXf::Zero(9, 1);
-		b(0, 0) = ((sff_v1 - sff_v0) * glm::vec2(cs.m_u)).x;
-		b(1, 0) = ((sff_v1 - sff_v0) * glm::vec2(cs.m_u)).y;
-		b(2, 0) = ((sff_v1 - sff_v0) * glm::vec2(cs.m_v)).y;
-		b(3, 0) = ((sff_v2 - sff_v1) * glm::vec2(cs.m_u)).x;
-		b(4, 0) = ((sff_v2 - sff_v1) * glm::vec2(cs.m_u)).y;
-		b(5, 0) = ((sff_v2 - sff_v1) * glm::vec2(cs.m_v)).y;
-		b(6, 0) = ((sff_v0 - sff_v2) * glm::vec2(cs.m_u)).x;
-		b(7, 0) = ((sff_v0 - sff_v2) * glm::vec2(cs.m_u)).y;
-		b(8, 0) = ((sff_v0 - sff_v2) * glm::vec2(cs.m_v)).y;
-
-		Eigen::Vector4f x = A.colPivHouseholderQr().solve(b);
-
-		struct MatCube m(x(0), x(1), x(2), x(3));
-		m_face_C[i] = m;
-	}
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			int idv0 = m_face[i].x;
+			int idv1 = m_face[i].y;
+			int idv2 = m_face[i].z;
+
+			// get edges
+			glm::vec3 e0 = m_vertex[idv1] - m_vertex[idv0];
+			glm::vec3 e1 = m_vertex[idv2] - m_vertex[idv1];
+			glm::vec3 e2 = m_vertex[idv0] - m_vertex[idv2];
+
+			// get all second fundamental form matrices
+			glm::mat2 sff_v0 = m_vertex_weingarten[idv0];
+			glm::mat2 sff_v1 = m_vertex_weingarten[idv1];
+			glm::mat2 sff_v2 = m_vertex_weingarten[idv2];
+
+			// get face coordinate system
+			struct CoordSys cs = m_face_coordSys[i];
+
+			// solve face's C matrix by using linear least squares :
+			// normal equations of the 9x4 system, a banded symmetric 4x4 matrix
+			glm::vec3 const edges[3] = { e0, e1, e2 };
+			glm::mat2 const sff_variations[3] = { sff_v1 - sff_v0, sff_v2 - sff_v1, sff_v0 - sff_v2 };
+			Eigen::Matrix4f AtA = Eigen::Matrix4f::Zero();
+			Eigen::Vector4f Atb = Eigen::Vector4f::Zero();
+			for (int k = 0; k < 3; ++k)
+			{
+				float eu = glm::dot(edges[k], cs.m_u);
+				float ev = glm::dot(edges[k], cs.m_v);
+				float b0 = (sff_variations[k] * glm::vec2(cs.m_u)).x;
+				float b1 = (sff_variations[k] * glm::vec2(cs.m_u)).y;
+				float b2 = (sff_variations[k] * glm::vec2(cs.m_v)).y;
+
+				AtA(0, 0) += eu * eu;
+				AtA(0, 1) += eu * ev;
+				AtA(1, 1) += ev * ev + eu * eu;
+				AtA(1, 2) += eu * ev;
+				AtA(2, 2) += ev * ev + eu * eu;
+				AtA(2, 3) += eu * ev;
+				AtA(3, 3) += ev * ev;
+
+				Atb(0) += eu * b0;
+				Atb(1) += ev * b0 + eu * b1;
+				Atb(2) += ev * b1 + eu * b2;
+				Atb(3) += ev * b2;
+			}
+			AtA(1, 0) = AtA(0, 1);
+			AtA(2, 1) = AtA(1, 2);
+			AtA(3, 2) = AtA(2, 3);
+
+			Eigen::Vector4f x = AtA.ldlt().solve(Atb);
+
+			struct MatCube m(x(0), x(1), x(2), x(3));
+			m_face_C[i] = m;
+		}
+	});
 }
 
-void Geometry::compute_per_vertex_C()
+void Geometry::compute_per_vertex_C(ThreadPool& iPool)
 {
-	for (size_t i = 0; i < m_vertex.size(); ++i)
+	iPool.parallel_for(0, m_vertex.size(), g_geometryGrain, [&](size_t iBegin, size_t iEnd)
 	{
-		glm::vec3 const& vertex_normal = m_vertex_normal[i];
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			glm::vec3 const& vertex_normal = m_vertex_normal[i];
+			m_vertex_C[i] = MatCube();
 
-		// express C matrices of all surrounding faces
-		// in terms of the current vertex coordinate system
-		std::vector<int> const& neighboring_faces = m_neighboring_faces[i];
-		float sum_weights = 0.0f;
+			// express C matrices of all surrounding faces
+			// in terms of the current vertex coordinate system
+			float sum_weights = 0.0f;
 
-		for (int const& fIdx : neighboring_faces)
-		{
-			glm::ivec3 face = m_face[fIdx];
-			struct CoordSys const& face_coordSys = m_face_coordSys[fIdx];
-			glm::vec3 const& face_normal = face_coordSys.m_w;
-
-			// get face voronoi area weight associated to current vertex
-			glm::vec3 weights = m_face_weingarten_weights[fIdx];
-			float weight = 0.0f;
-			if (face.x == i) { weight = weights.x; }
-			else if (face.y == i) { weight = weights.y; }
-			else { weight = weights.z; }
-			sum_weights += weight;
-
-			// get face's C matrix, and vector quantities of the vertex and face's coordinate systems
-			struct MatCube const& C = m_face_C[fIdx];
-			glm::vec3 Up = m_vertex_coordSys[i].m_u;
-			glm::vec3 Vp = m_vertex_coordSys[i].m_v;
-			glm::vec3 Uf = face_coordSys.m_u;
-			glm::vec3 Vf = face_coordSys.m_v;
-
-			// check if normals are parallel (compute rotation or not ?)
-			float cos_normals = glm::dot(face_normal, vertex_normal);
-			if (cos_normals > 0.998f) // parallel => no rotation
+			for (int const& c : m_corners.corners(i))
 			{
-				// now get vertex C matrix
-				// in this new coordinate system (Uf, Vf) : vertex coordinate system expressed in face's one
-				float UpUf = glm::dot(Up, Uf);
-				float UpVf = glm::dot(Up, Vf);
-				float VpUf = glm::dot(Vp, Uf);
-				float VpVf = glm::dot(Vp, Vf);
-
-				float a = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), ((C * glm::normalize(glm::vec2(UpUf, UpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
-				float b = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
-				float c = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
-				float d = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(VpUf, VpVf))));
-
-				struct MatCube tensorC(a, b, c, d);
-				m_vertex_C[i] += tensorC * weight;
+				if (m_corners.repeats_vertex(c)) { continue; }
+				int fIdx = CornerTable::face(c);
+				struct CoordSys const& face_coordSys = m_face_coordSys[fIdx];
+				glm::vec3 const& face_normal = face_coordSys.m_w;
+
+				// get face voronoi area weight associated to current vertex
+				float weight = m_face_weingarten_weights[fIdx][c % 3];
+				sum_weights += weight;
+
+				// get face's C matrix, and vector quantities of the vertex and face's coordinate systems
+				struct MatCube const& C = m_face_C[fIdx];
+				glm::vec3 Up = m_vertex_coordSys[i].m_u;
+				glm::vec3 Vp = m_vertex_coordSys[i].m_v;
+				glm::vec3 Uf = face_coordSys.m_u;
+				glm::vec3 Vf = face_coordSys.m_v;
+
+				// check if normals are parallel (compute rotation or not ?)
+				float cos_normals = glm::dot(face_normal, vertex_normal);
+				if (cos_normals > 0.998f) // parallel => no rotation
+				{
+					// now get vertex C matrix
+					// in this new coordinate system (Uf, Vf) : vertex coordinate system expressed in face's one
+					float UpUf = glm::dot(Up, Uf);
+					float UpVf = glm::dot(Up, Vf);
+					float VpUf = glm::dot(Vp, Uf);
+					float VpVf = glm::dot(Vp, Vf);
+
+					float a = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), ((C * glm::normalize(glm::vec2(UpUf, UpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
+					float b = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
+					float cw = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
+					float d = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(VpUf, VpVf))));
+
+					struct MatCube tensorC(a, b, cw, d);
+					m_vertex_C[i] += tensorC * weight;
+				}
+				else
+				{
+					// axis of rotation for coordinate system transform
+					glm::vec3 axis = glm::cross(face_normal, vertex_normal);
+					axis = glm::normalize(axis);
+
+					// compute rotation angle from face coordinate system
+					// to the current vertex coordinate system
+					float angle = acos(glm::dot(face_normal, vertex_normal) / (glm::length(face_normal) * glm::length(vertex_normal)));
+					glm::quat q = glm::angleAxis(angle, axis);
+
+					// rotate face coordinate system
+					glm::vec3 face_up = q * face_coordSys.m_u;
+					glm::vec3 face_vp = q * face_coordSys.m_v;
+					glm::vec3 face_wp = q * face_coordSys.m_w;
+
+					// now get curvature tensor
+					// in this new coordinate system (Up, Vp) : vertex coordinate system
+					Uf = face_up;
+					Vf = face_vp;
+
+					float UpUf = glm::dot(Up, Uf);
+					float UpVf = glm::dot(Up, Vf);
+					float VpUf = glm::dot(Vp, Uf);
+					float VpVf = glm::dot(Vp, Vf);
+
+					float a = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), ((C * glm::normalize(glm::vec2(UpUf, UpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
+					float b = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
+					float cw = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
+					float d = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(VpUf, VpVf))));
+
+					struct MatCube tensorC(a, b, cw, d);
+					m_vertex_C[i] += tensorC * weight;
+				}
 			}
-			else
+			if (sum_weights != 0.0f)
 			{
-				// axis of rotation for coordinate system transform
-				glm::vec3 axis = glm::cross(face_normal, vertex_normal);
-				axis = glm::normalize(axis);
-
-				// compute rotation angle from face coordinate system
-				// to the current vertex coordinate system
-				float angle = acos(glm::dot(face_normal, vertex_normal) / (glm::length(face_normal) * glm::length(vertex_normal)));
-				glm::quat q = glm::angleAxis(angle, axis);
-
-				// rotate face coordinate system
-				glm::vec3 face_up = q * face_coordSys.m_u;
-				glm::vec3 face_vp = q * face_coordSys.m_v;
-				glm::vec3 face_wp = q * face_coordSys.m_w;
-
-				// now get curvature tensor
-				// in this new coordinate system (Up, Vp) : vertex coordinate system
-				Uf = face_up;
-				Vf = face_vp;
-
-				float UpUf = glm::dot(Up, Uf);
-				float UpVf = glm::dot(Up, Vf);
-				float VpUf = glm::dot(Vp, Uf);
-				float VpVf = glm::dot(Vp, Vf);
-
-				float a = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), ((C * glm::normalize(glm::vec2(UpUf, UpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
-				float b = glm::dot(glm::normalize(glm::vec2(UpUf, UpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
-				float c = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(UpUf, UpVf))));
-				float d = glm::dot(glm::normalize(glm::vec2(VpUf, VpVf)), ((C * glm::normalize(glm::vec2(VpUf, VpVf))) * glm::normalize(glm::vec2(VpUf, VpVf))));
-
-				struct MatCube tensorC(a, b, c, d);
-				m_vertex_C[i] += tensorC * weight;
+				m_vertex_C[i] /= sum_weights;
 			}
 		}
-		if (sum_weights != 0.0f)
-		{
-			m_vertex_C[i] /= sum_weights;
-		}
-	}
-}
\ No newline at end of file
+	});
+}
@@ -1,22 +1,35 @@
 #pragma once
 
 #include <Eigen/Dense>
-#include <Eigen/Eigenvalues>
-#include <Eigen/unsupported/Eigen/MatrixFunctions>
+#include <Eigen/Sparse>
 #include <vector>
 #include <array>
 #include <glm/gtx/string_cast.hpp>
-#include <random>
 #include "camera.hpp"
 #include "shader.hpp"
+#include "topology.hpp"
+#include "taubin.hpp"
+#include "curvature_cache.hpp"
+#include "contours.hpp"
+#include "silhouettes.hpp"
+#include "cleanup.hpp"
+#include "reorder.hpp"
+#include "draw_order.hpp"
+#include "vertex_format.hpp"
 
 constexpr float g_halfPI = glm::pi<float>() / 2.0f;
+// faces or vertices per parallel_for block of the geometry stages
+constexpr size_t g_geometryGrain = 1024;
+static_assert(g_geometryGrain % g_taubinLanes == 0, "blocks must hold whole batches");
 
 float triangle_corner_angle(glm::vec3 const& corner, glm::vec3 const& a, glm::vec3 const& b);
 float compute_voronoi_region_of_vertex_in_triangle(glm::vec3 const& vertex, glm::vec3 const& a, glm::vec3 const& b);
 float cot(float angle);
 float triangle_area(glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c);
-float gen_random(float from, float to);
+void orthonormal_basis(glm::vec3 const& n, glm::vec3& u, glm::vec3& v);
+void symmetric_eigen_2x2(float a, float b, float c, float& k1, float& k2, float& cos_theta, float& sin_theta);
+void symmetric_eigen_2x2_batch(size_t iCount, float const* a, float const* b, float const* c,
+	float* k1, float* k2, float* cos_theta, float* sin_theta);
 
 struct CoordSys
 {
@@ -76,8 +89,7 @@ struct Geometry
 	// vertices'data
 	std::vector<glm::vec3> m_vertex;
 	std::vector<glm::vec3> m_vertex_normal;
-	std::vector<std::vector<int>> m_neighboring_faces;
-	std::vector<std::vector<int>> m_neighboring_vertices;
+	struct Adjacency m_vertex_vertices;						// one-ring of each vertex
 	std::vector<glm::vec3> m_t1;							// principal direction t1
 	std::vector<glm::vec3> m_t2;							// principal direction t2
 	std::vector<float> m_K1;								// principal curvature K1 (max) computed from curvature tensor
@@ -95,55 +107,138 @@ struct Geometry
 	std::vector<struct MatCube> m_face_C;
 	std::vector<struct CoordSys> m_face_coordSys;
 
-	// Taubin smoothing
-	float Kpb;
-	float lambda;
-	unsigned int N;
-	float mu;
-	Eigen::MatrixXd m_W; // weights matrix
-	Eigen::MatrixXd m_K; // circulant matrix
+	bool load(std::string const& iPath, ThreadPool& iPool);
+	void cleanup(ThreadPool& iPool, CleanupOptions const& iOptions);
+	void reorder(ThreadPool& iPool);
+	void optimize_draw_order();
+	void load_streams(VertexStreams const& iStreams);
+
+	// topology
+	struct CornerTable m_corners;
+	void compute_adjacency();
+
+	// Taubin smoothing, low-pass transfer function
+	float Kpb = 0.095f;
+	float lambda = 0.6307f;
+	unsigned int N = 25;
+	float mu = lambda / ((lambda * Kpb) - 1.0f); // from 1/lambda + 1/mu = Kpb
+	Eigen::SparseMatrix<float, Eigen::RowMajor> m_W; // weights matrix, the circulant matrix is K = I - W
 
 	void compute_circulant_matrix();
 	float phi(glm::vec3 vi, glm::vec3 vj);
-	Eigen::MatrixXd transfer_function(Eigen::MatrixXd& m);
+	void apply_taubin_filter();
 
 	// curvatures
 	float m_minKg;
 	float m_maxKg;
 	float m_minH;
 	float m_maxH;
-	void compute_per_face_weingarten_matrix();
+	void compute_curvatures(ThreadPool& iPool);
+	void compute_normals(ThreadPool& iPool);
+	void compute_per_face_weingarten_matrix(ThreadPool& iPool);
 	void compute_face_mixed_voronoi_area(glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c, glm::vec3 & weights);
-	void compute_per_vertex_weingarten_matrix();
+	void compute_per_vertex_weingarten_matrix(ThreadPool& iPool);
 	void compute_min_max();
-	void compute_per_face_C();
-	void compute_per_vertex_C();
+	void compute_per_face_C(ThreadPool& iPool);
+	void compute_per_vertex_C(ThreadPool& iPool);
+
+	// GPU vertices straight from the pipeline results, oVertex can be a mapped buffer
+	void pack_vertices(ThreadPool& iPool, PackedVertex* oVertex) const;
 };
 
+// processing applied to the mesh file when it is loaded, set from the command line
+struct MeshOptions
+{
+	CleanupOptions m_cleanup;
+	bool m_reorder = false;		// vertices and faces in space filling curve order
+	bool m_draw_order = false;	// faces in vertex cache and overdraw friendly order
+
+	// curvature cache key of a source file loaded with these options
+	uint64_t cache_key(uint64_t iSourceHash) const;
+	// reads one command line argument, false when it is not a mesh option
+	bool parse(char const* iArg);
+};
+
+// VertexStreams of a Geometry, owning the arrays Geometry does not store in VBO layout
+struct GeometryStreams
+{
+	GeometryStreams(Geometry const& iGeom);
+
+	std::vector<glm::vec3> m_tangent_u;
+	std::vector<glm::vec3> m_tangent_v;
+	std::vector<glm::mat2> m_C1;
+	std::vector<glm::mat2> m_C2;
+	VertexStreams m_streams;
+};
+
+// everything the lines of Mesh::update_contour_lines depend on
+struct ContourLineInputs
+{
+	unsigned int m_mesh_version = 0;
+	glm::vec3 m_view_position = glm::vec3(0.0f);		// in object space
+	bool m_suggestive = false;
+	SuggestiveContourOptions m_options;
+	bool m_silhouettes = false;
+	bool m_edge_silhouettes = false;
+
+	bool operator==(ContourLineInputs const& iOther) const;
+};
+
+// texture units of the buffer textures, see the samplers of shaders/fragment.glsl
+constexpr GLint g_vertexTextureUnit = 0;
+constexpr GLint g_indexTextureUnit = 1;
+
+// largest glyph stride : GL 4.4 only guarantees 2048 byte vertex attribute strides
+constexpr int g_maxGlyphStride = 2048 / sizeof(PackedVertex);
+
 struct Mesh
 {
-	Mesh(std::string const & iPath);
+	Mesh(std::string const & iPath, MeshOptions const& iOptions);
 	~Mesh();
-	void create_GPU_objects();
-	void get_neighboring_faces(int vertex_id, std::vector<int>& neighbors);
-	void get_neighbors(int vertex_id, std::vector<int>& neighboring_vertices, std::vector<int>& neighboring_faces);
+	void create_GPU_objects(VertexStreams const& iStreams);
 	void taubin_smoothing();
-	void update_pos_vbo();
-	void update_normal_vbo();
-	void update_curvature_vbos();
+	void update_vbo();
+	void bind_vertex_buffer(GLuint iVbo);
+	void bind_buffer_textures() const;
+	void bind_glyph_buffer(GLuint iVbo, int iStride);
+	void draw_glyphs(bool iT1, bool iT2, int iStride);
+	void draw_wireframe() const;
+	void update_contour_lines(glm::vec3 const& iViewPosition, bool iSuggestive, SuggestiveContourOptions const& iOptions, bool iSilhouettes, bool iEdgeSilhouettes);
+	void draw_contour_lines() const;
 
 	struct Geometry m_geom;
+	unsigned int m_version;		// incremented whenever the vertices change
 	GLuint m_vao;
-	GLuint m_posvbo;
-	GLuint m_normalvbo;
-	GLuint m_tangent_U;
-	GLuint m_tangent_V;
-	GLuint m_K1Vbo;
-	GLuint m_K2Vbo;
-	GLuint m_T1Vbo;
-	GLuint m_T2Vbo;
-	GLuint m_C1Vbo;
-	GLuint m_C2Vbo;
+	// PackedVertex buffers : one is drawn from while the other is rewritten after smoothing,
+	// the fence of a retired buffer tells when the GPU is done reading it
+	GLuint m_vbo[2];
+	GLsync m_vbo_fence[2];
+	int m_current_vbo;
 	GLuint m_ebo;
+	// the current VBO as float pairs and the EBO as indices, the wireframe reads the corners of its triangle through them
+	GLuint m_vertex_texture;
+	GLuint m_index_texture;
+	// attributeless VAO of the wireframe, only drawn when the buffer textures cover the mesh
+	GLuint m_wireframe_vao;
+	bool m_wireframe;
+	// principal direction glyphs, one instance for every m_glyph_stride-th vertex of the current VBO
+	GLuint m_glyph_vao;
+	int m_glyph_stride;
+	// bounding sphere, to estimate the screen space density of the vertices
+	glm::vec3 m_center;
+	float m_radius;
+	// object space suggestive contours and silhouettes of the last viewpoint, drawn as lines
+	SuggestiveContourExtractor m_contours;
+	SilhouetteExtractor m_silhouettes;
+	std::vector<glm::vec3> m_contour_segment;
+	std::vector<glm::vec3> m_silhouette_edge;
+	std::vector<glm::vec3> m_silhouette_smooth;
+	GLuint m_contour_vao;
+	GLuint m_contour_vbo;
+	size_t m_contour_capacity;			// bytes allocated for m_contour_vbo
+	GLsizei m_contour_vertex_count;
+	// inputs of the lines in m_contour_vbo, they are only extracted and uploaded again when these change
+	bool m_has_contour_lines;
+	ContourLineInputs m_contour_inputs;
 	glm::mat4 m_model;
 };
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "reorder.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+
+namespace
+{
+	constexpr size_t g_reorderGrain = 4096;
+	constexpr float g_maxCell = static_cast<float>((1 << 21) - 1);
+
+	// 21 bits of every coordinate, interleaved in a 63 bits key
+	uint64_t spread_bits(uint64_t iValue)
+	{
+		iValue &= 0x1FFFFF;
+		iValue = (iValue | (iValue << 32)) & 0x1F00000000FFFFull;
+		iValue = (iValue | (iValue << 16)) & 0x1F0000FF0000FFull;
+		iValue = (iValue | (iValue << 8)) & 0x100F00F00F00F00Full;
+		iValue = (iValue | (iValue << 4)) & 0x10C30C30C30C30C3ull;
+		iValue = (iValue | (iValue << 2)) & 0x1249249249249249ull;
+		return iValue;
+	}
+
+	uint64_t morton_code(glm::uvec3 const& iCell)
+	{
+		return spread_bits(iCell.x) | (spread_bits(iCell.y) << 1) | (spread_bits(iCell.z) << 2);
+	}
+}
+
+void reorder_mesh(ThreadPool& iPool, std::vector<glm::vec3>& ioVertex, std::vector<glm::ivec3>& ioFace, std::vector<unsigned int>& ioIndex)
+{
+	size_t vertex_count = ioVertex.size();
+	size_t face_count = ioFace.size();
+	if (vertex_count == 0) { return; }
+
+	glm::vec3 min_corner(std::numeric_limits<float>::max());
+	glm::vec3 max_corner(-std::numeric_limits<float>::max());
+	for (glm::vec3 const& v : ioVertex)
+	{
+		min_corner = glm::min(min_corner, v);
+		max_corner = glm::max(max_corner, v);
+	}
+
+	// cubic grid of 2^21 cells per side over the bounding box, ties are broken by the file order
+	glm::vec3 size = max_corner - min_corner;
+	float scale = g_maxCell / std::max(std::max(size.x, size.y), std::max(size.z, std::numeric_limits<float>::min()));
+	std::vector<std::pair<uint64_t, int>> vertex_order(vertex_count);
+	iPool.parallel_for(0, vertex_count, g_reorderGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			glm::vec3 cell = glm::clamp((ioVertex[i] - min_corner) * scale, glm::vec3(0.0f), glm::vec3(g_maxCell));
+			vertex_order[i] = { morton_code(glm::uvec3(cell)), static_cast<int>(i) };
+		}
+	});
+	std::sort(vertex_order.begin(), vertex_order.end());
+
+	std::vector<glm::vec3> vertex(vertex_count);
+	std::vector<int> new_index(vertex_count);
+	iPool.parallel_for(0, vertex_count, g_reorderGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t k = iBegin; k < iEnd; ++k)
+		{
+			vertex[k] = ioVertex[vertex_order[k].second];
+			new_index[vertex_order[k].second] = static_cast<int>(k);
+		}
+	});
+	ioVertex.swap(vertex);
+
+	// faces by smallest new vertex index, then by file order
+	std::vector<uint64_t> face_order(face_count);
+	iPool.parallel_for(0, face_count, g_reorderGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t f = iBegin; f < iEnd; ++f)
+		{
+			glm::ivec3& face = ioFace[f];
+			face = glm::ivec3(new_index[face.x], new_index[face.y], new_index[face.z]);
+			uint64_t first = static_cast<uint64_t>(std::min(face.x, std::min(face.y, face.z)));
+			face_order[f] = (first << 32) | f;
+		}
+	});
+	std::sort(face_order.begin(), face_order.end());
+
+	std::vector<glm::ivec3> face(face_count);
+	ioIndex.resize(3 * face_count);
+	iPool.parallel_for(0, face_count, g_reorderGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t f = iBegin; f < iEnd; ++f)
+		{
+			face[f] = ioFace[face_order[f] & 0xFFFFFFFFull];
+			ioIndex[3 * f] = face[f].x;
+			ioIndex[3 * f + 1] = face[f].y;
+			ioIndex[3 * f + 2] = face[f].z;
+		}
+	});
+	ioFace.swap(face);
+}
+
+double mean_neighbor_distance(std::vector<glm::ivec3> const& iFace)
+{
+	// mean over the face edges, an interior edge is gathered once from each of its vertices
+	double sum = 0.0;
+	for (glm::ivec3 const& face : iFace)
+	{
+		sum += std::abs(face.x - face.y) + std::abs(face.y - face.z) + std::abs(face.z - face.x);
+	}
+	return iFace.empty() ? 0.0 : sum / (3.0 * iFace.size());
+}
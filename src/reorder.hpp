@@ -0,0 +1,14 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "thread_pool.hpp"
+
+// vertices sorted along a Morton curve of their position, then faces sorted by their
+// smallest vertex, so that the vertices and faces close in space are close in memory.
+// Faces keep their orientation and the result does not depend on the thread count.
+void reorder_mesh(ThreadPool& iPool, std::vector<glm::vec3>& ioVertex, std::vector<glm::ivec3>& ioFace, std::vector<unsigned int>& ioIndex);
+
+// average |i - j| over the one-ring neighbors j of every vertex i : the stride of the gathers
+// of the per-vertex stages, a portable locality measure when no cache counter is available
+double mean_neighbor_distance(std::vector<glm::ivec3> const& iFace);
@@ -1,5 +1,70 @@
 #include "shader.hpp"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "curvature_cache.hpp"
+#include "mapped_file.hpp"
+
+// GL 4.1 program binary enums, glad is generated for GL 3.3
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+namespace
+{
+	// program binary entry points, loaded through GLFW since glad does not provide them
+	struct ProgramBinaryApi
+	{
+		typedef void (APIENTRYP GetProgramBinary)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+		typedef void (APIENTRYP ProgramBinary)(GLuint, GLenum, const void*, GLsizei);
+		typedef void (APIENTRYP ProgramParameteri)(GLuint, GLenum, GLint);
+
+		GetProgramBinary m_getProgramBinary = nullptr;
+		ProgramBinary m_programBinary = nullptr;
+		ProgramParameteri m_programParameteri = nullptr;
+		bool m_supported = false;		// entry points found and at least one binary format
+	};
+
+	ProgramBinaryApi const& programBinaryApi()
+	{
+		static ProgramBinaryApi api = []()
+		{
+			ProgramBinaryApi result;
+			result.m_getProgramBinary = reinterpret_cast<ProgramBinaryApi::GetProgramBinary>(glfwGetProcAddress("glGetProgramBinary"));
+			result.m_programBinary = reinterpret_cast<ProgramBinaryApi::ProgramBinary>(glfwGetProcAddress("glProgramBinary"));
+			result.m_programParameteri = reinterpret_cast<ProgramBinaryApi::ProgramParameteri>(glfwGetProcAddress("glProgramParameteri"));
+			if (result.m_getProgramBinary && result.m_programBinary && result.m_programParameteri)
+			{
+				GLint formats = 0;
+				glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+				result.m_supported = formats > 0;
+			}
+			return result;
+		}();
+		return api;
+	}
+
+	struct ProgramBinaryHeader
+	{
+		char m_magic[8];
+		uint32_t m_version;
+		uint32_t m_format;
+		uint64_t m_key;
+		uint64_t m_length;
+		double m_source_build_ms;		// compile and link time from source, to report the time saved
+	};
+
+	constexpr char g_programMagic[8] = { 'S', 'C', 'P', 'R', 'O', 'G', '\0', '\0' };
+	constexpr uint32_t g_programBinaryVersion = 1;
+}
+
 std::string file2String(std::string const & iFile)
 {
 	std::ifstream fileStream(iFile.c_str());
@@ -16,20 +81,65 @@ std::string file2String(std::string const & iFile)
 	}
 }
 
+std::string loadShaderSource(std::string const& iFile)
+{
+	std::string directory = iFile.substr(0, iFile.find_last_of("/\\") + 1);
+	std::istringstream source(file2String(iFile));
+	std::string result;
+	std::string line;
+	while (std::getline(source, line))
+	{
+		size_t directive = line.find("#include");
+		size_t open = line.find('"');
+		size_t close = line.rfind('"');
+		if (directive != std::string::npos && line.find_first_not_of(" \t") == directive && open != std::string::npos && close > open)
+		{
+			// every line of the included file already ends with a newline
+			result += loadShaderSource(directory + line.substr(open + 1, close - open - 1));
+			continue;
+		}
+		result += line;
+		result += '\n';
+	}
+	return result;
+}
+
+std::string injectDefines(std::string const& iSource, std::vector<std::string> const& iDefines)
+{
+	if (iDefines.empty()) { return iSource; }
+
+	std::string defines;
+	for (std::string const& define : iDefines)
+	{
+		defines += "#define " + define + '\n';
+	}
+	// #version must stay the first statement
+	size_t insert = 0;
+	size_t version = iSource.find("#version");
+	if (version != std::string::npos)
+	{
+		size_t end = iSource.find('\n', version);
+		insert = (end == std::string::npos) ? iSource.size() : end + 1;
+	}
+	std::string result = iSource.substr(0, insert);
+	if (!result.empty() && result.back() != '\n') { result += '\n'; }
+	return result + defines + iSource.substr(insert);
+}
+
 void Shader::checkCompileError(GLuint const & iShader, GLenum iType)
 {
 	int success;
 	int logLength;
-	std::unique_ptr<char> log;
+	std::unique_ptr<char[]> log;
 
 	glGetShaderiv(iShader, GL_COMPILE_STATUS, &success);
 	if (success == GL_FALSE)
 	{
 		glGetShaderiv(iShader, GL_INFO_LOG_LENGTH, &logLength);
-		log = std::make_unique<char>(logLength);
+		log = std::make_unique<char[]>(logLength);
 		glGetShaderInfoLog(iShader, logLength, nullptr, log.get());
-		std::cerr << "Error while compiling the " << ((iType == GL_VERTEX_SHADER) ? "vertex" : "fragment") << " shader : " << log << std::endl;
-		glDeleteShader(iShader);
+		char const* stage = (iType == GL_VERTEX_SHADER) ? "vertex" : ((iType == GL_GEOMETRY_SHADER) ? "geometry" : "fragment");
+		std::cerr << "Error while compiling the " << stage << " shader : " << log.get() << std::endl;
 	}
 }
 
@@ -37,92 +147,216 @@ bool Shader::checkLinkError()
 {
 	int success;
 	int logLength;
-	std::unique_ptr<char> log;
+	std::unique_ptr<char[]> log;
 
 	glGetProgramiv(m_program, GL_LINK_STATUS, &success);
 	if (success == GL_FALSE)
 	{
 		glGetProgramiv(m_program, GL_INFO_LOG_LENGTH, &logLength);
-		log = std::make_unique<char>(logLength);
+		log = std::make_unique<char[]>(logLength);
 		glGetProgramInfoLog(m_program, logLength, nullptr, log.get());
-		std::cerr << "Error while linking shaders into a program : " << log << std::endl;
+		std::cerr << "Error while linking shaders into a program : " << log.get() << std::endl;
 		return false;
 	}
 	return true;
 }
 
-Shader::Shader(std::string const& iVertex, std::string const& iFragment)
+Shader::Shader(std::string const& iVertex, std::string const& iFragment, std::vector<std::string> const& iDefines)
 {
-	GLuint vShader = glCreateShader(GL_VERTEX_SHADER);
-	std::string vShaderString = file2String(iVertex);
-	const GLchar* vShaderSource = (const GLchar*)vShaderString.c_str();
-	glShaderSource(vShader, 1, &vShaderSource, NULL);
-	glCompileShader(vShader);
+	build({ { GL_VERTEX_SHADER, iVertex }, { GL_FRAGMENT_SHADER, iFragment } }, iDefines);
+}
 
-	GLuint fShader = glCreateShader(GL_FRAGMENT_SHADER);
-	std::string fShaderString = file2String(iFragment);
-	const GLchar* fShaderSource = (const GLchar*)fShaderString.c_str();
-	glShaderSource(fShader, 1, &fShaderSource, NULL);
-	glCompileShader(fShader);
+Shader::Shader(std::string const & iVertex, std::string const& iGeometry, std::string const& iFragment, std::vector<std::string> const& iDefines)
+{
+	build({ { GL_VERTEX_SHADER, iVertex }, { GL_GEOMETRY_SHADER, iGeometry }, { GL_FRAGMENT_SHADER, iFragment } }, iDefines);
+}
+
+// linked program from the binary cache when it matches the sources and the driver, else from source
+void Shader::build(std::vector<std::pair<GLenum, std::string>> const& iStages, std::vector<std::string> const& iDefines)
+{
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::string> sources;
+	std::string identity;
+	for (auto const& stage : iStages)
+	{
+		sources.push_back(injectDefines(loadShaderSource(stage.second), iDefines));
+		identity += stage.second + '\n';
+	}
+	for (std::string const& define : iDefines) { identity += define + '\n'; }
+
+	// one cache file per program and define set, its key covers the expanded sources and the driver
+	std::string key_data = identity;
+	for (std::string const& source : sources) { key_data += source; }
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		char const* value = reinterpret_cast<char const*>(glGetString(name));
+		key_data += (value != nullptr) ? value : "";
+	}
+	uint64_t key = hash_bytes(reinterpret_cast<unsigned char const*>(key_data.data()), key_data.size());
+	std::ostringstream cache_path;
+	cache_path << iStages.back().second << '.' << std::hex << hash_bytes(reinterpret_cast<unsigned char const*>(identity.data()), identity.size()) << ".program";
+	m_binaryPath = cache_path.str();
+
+	m_program = glCreateProgram();
+	double source_build_ms = 0.0;
+	if (loadProgramBinary(key, source_build_ms))
+	{
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "program cache : " << m_binaryPath << " loaded in " << ms << " ms, " << source_build_ms - ms << " ms saved" << std::endl;
+		reflectUniforms();
+		return;
+	}
+
+	std::vector<GLuint> shaders;
+	for (size_t s = 0; s < iStages.size(); ++s)
+	{
+		GLuint shader = glCreateShader(iStages[s].first);
+		const GLchar* source = (const GLchar*)sources[s].c_str();
+		glShaderSource(shader, 1, &source, NULL);
+		glCompileShader(shader);
+		shaders.push_back(shader);
+	}
 
 	// Check for errors
-	checkCompileError(vShader, GL_VERTEX_SHADER);
-	checkCompileError(fShader, GL_FRAGMENT_SHADER);
+	for (size_t s = 0; s < iStages.size(); ++s)
+	{
+		checkCompileError(shaders[s], iStages[s].first);
+	}
 
 	// create program
-	m_program = glCreateProgram();
-	glAttachShader(m_program, vShader);
-	glAttachShader(m_program, fShader);
+	if (programBinaryApi().m_supported)
+	{
+		programBinaryApi().m_programParameteri(m_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	for (GLuint shader : shaders) { glAttachShader(m_program, shader); }
 	glLinkProgram(m_program);
-	if (!checkLinkError())
+	bool linked = checkLinkError();
+	for (GLuint shader : shaders)
 	{
-		glDeleteShader(vShader);
-		glDeleteShader(fShader);
+		glDetachShader(m_program, shader);
+		glDeleteShader(shader);
+	}
+	reflectUniforms();
+
+	if (linked)
+	{
+		source_build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		saveProgramBinary(key, source_build_ms);
 	}
-	glDetachShader(m_program, vShader);
-	glDetachShader(m_program, fShader);
 }
 
-Shader::Shader(std::string const & iVertex, std::string const& iGeometry, std::string const& iFragment)
+bool Shader::loadProgramBinary(uint64_t iKey, double& oSourceBuildMs)
 {
-	GLuint vShader = glCreateShader(GL_VERTEX_SHADER);
-	std::string vShaderString = file2String(iVertex);
-	const GLchar* vShaderSource = (const GLchar*)vShaderString.c_str();
-	glShaderSource(vShader, 1, &vShaderSource, NULL);
-	glCompileShader(vShader);
+	ProgramBinaryApi const& api = programBinaryApi();
+	MappedFile file;
+	if (!api.m_supported || !file.open(m_binaryPath) || file.size() < sizeof(ProgramBinaryHeader)) { return false; }
 
-	GLuint gShader = glCreateShader(GL_GEOMETRY_SHADER);
-	std::string gShaderString = file2String(iGeometry);
-	const GLchar* gShaderSource = (const GLchar*)gShaderString.c_str();
-	glShaderSource(gShader, 1, &gShaderSource, NULL);
-	glCompileShader(gShader);
+	ProgramBinaryHeader header;
+	std::memcpy(&header, file.data(), sizeof(ProgramBinaryHeader));
+	if (std::memcmp(header.m_magic, g_programMagic, sizeof(g_programMagic)) != 0 ||
+		header.m_version != g_programBinaryVersion ||
+		header.m_key != iKey ||
+		header.m_length != file.size() - sizeof(ProgramBinaryHeader))
+	{
+		std::cout << "program cache : " << m_binaryPath << " is stale, compiling from source" << std::endl;
+		return false;
+	}
 
-	GLuint fShader = glCreateShader(GL_FRAGMENT_SHADER);
-	std::string fShaderString = file2String(iFragment);
-	const GLchar* fShaderSource = (const GLchar*)fShaderString.c_str();
-	glShaderSource(fShader, 1, &fShaderSource, NULL);
-	glCompileShader(fShader);
-	
-	// Check for errors
-	checkCompileError(vShader, GL_VERTEX_SHADER);
-	checkCompileError(fShader, GL_GEOMETRY_SHADER);
-	checkCompileError(fShader, GL_FRAGMENT_SHADER);
+	// a driver update can reject the binary even with the same version strings
+	api.m_programBinary(m_program, header.m_format, file.data() + sizeof(ProgramBinaryHeader), static_cast<GLsizei>(header.m_length));
+	GLint success = GL_FALSE;
+	glGetProgramiv(m_program, GL_LINK_STATUS, &success);
+	if (success == GL_FALSE)
+	{
+		std::cerr << "WARN: program binary " << m_binaryPath << " rejected by the driver, compiling from source" << std::endl;
+		return false;
+	}
+	oSourceBuildMs = header.m_source_build_ms;
+	return true;
+}
 
-	// create program
-	m_program = glCreateProgram();
-	glAttachShader(m_program, vShader);
-	glAttachShader(m_program, gShader);
-	glAttachShader(m_program, fShader);
-	glLinkProgram(m_program);
-	if (!checkLinkError())
+void Shader::saveProgramBinary(uint64_t iKey, double iSourceBuildMs) const
+{
+	ProgramBinaryApi const& api = programBinaryApi();
+	if (!api.m_supported) { return; }
+
+	GLint length = 0;
+	glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) { return; }
+	std::vector<char> binary(length);
+	GLsizei written = 0;
+	GLenum format = 0;
+	api.m_getProgramBinary(m_program, length, &written, &format, binary.data());
+	if (written <= 0) { return; }
+
+	ProgramBinaryHeader header;
+	std::memcpy(header.m_magic, g_programMagic, sizeof(g_programMagic));
+	header.m_version = g_programBinaryVersion;
+	header.m_format = format;
+	header.m_key = iKey;
+	header.m_length = static_cast<uint64_t>(written);
+	header.m_source_build_ms = iSourceBuildMs;
+
+	// write to a temporary file then rename it, a reader never sees a partial binary
+	std::string temporary_path = m_binaryPath + ".tmp";
+	bool saved = false;
 	{
-		glDeleteShader(vShader);
-		glDeleteShader(gShader);
-		glDeleteShader(fShader);
+		std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+		if (file)
+		{
+			file.write(reinterpret_cast<char const*>(&header), sizeof(ProgramBinaryHeader));
+			file.write(binary.data(), written);
+			file.flush();
+			saved = static_cast<bool>(file);
+		}
 	}
-	glDetachShader(m_program, vShader);
-	glDetachShader(m_program, gShader);
-	glDetachShader(m_program, fShader);
+	if (saved)
+	{
+		std::remove(m_binaryPath.c_str());
+		saved = std::rename(temporary_path.c_str(), m_binaryPath.c_str()) == 0;
+	}
+	if (!saved)
+	{
+		std::remove(temporary_path.c_str());
+		std::cerr << "WARN: could not write program binary " << m_binaryPath << std::endl;
+	}
+}
+
+// uniform locations are looked up once at link time, and the Frame block is bound to its buffer
+void Shader::reflectUniforms()
+{
+	m_uniforms.clear();
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> name(maxLength + 1);
+	for (GLint i = 0; i < count; ++i)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(m_program, i, maxLength + 1, &length, &size, &type, name.data());
+		std::string uniform(name.data(), length);
+		GLint location = glGetUniformLocation(m_program, uniform.c_str());
+		if (location == -1) { continue; } // member of a uniform block
+
+		// arrays are reported as name[0]
+		if (uniform.size() > 3 && uniform.compare(uniform.size() - 3, 3, "[0]") == 0) { uniform.resize(uniform.size() - 3); }
+		m_uniforms[uniform] = location;
+	}
+
+	GLuint frameBlock = glGetUniformBlockIndex(m_program, "Frame");
+	if (frameBlock != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(m_program, frameBlock, g_frameUniformBinding);
+	}
+}
+
+GLint Shader::uniformLocation(std::string const& iUniform) const
+{
+	auto it = m_uniforms.find(iUniform);
+	return (it != m_uniforms.end()) ? it->second : -1;
 }
 
 Shader::~Shader()
@@ -130,27 +364,27 @@ Shader::~Shader()
 	glDeleteProgram(m_program);
 }
 
-void Shader::setMat4f(std::string const & iUniform, glm::mat4 const& iMat)
+void Shader::setMat4f(GLint iLocation, glm::mat4 const& iMat)
 {
-	glUniformMatrix4fv(glGetUniformLocation(m_program, iUniform.c_str()), 1, GL_FALSE, glm::value_ptr(iMat));
+	glUniformMatrix4fv(iLocation, 1, GL_FALSE, glm::value_ptr(iMat));
 }
 
-void Shader::setVec3f(std::string const& iUniform, glm::vec3 const& iVec)
+void Shader::setVec3f(GLint iLocation, glm::vec3 const& iVec)
 {
-	glUniform3f(glGetUniformLocation(m_program, iUniform.c_str()), iVec.x, iVec.y, iVec.z);
+	glUniform3f(iLocation, iVec.x, iVec.y, iVec.z);
 }
 
-void Shader::setInt(std::string const& iUniform, int const& iValue)
+void Shader::setInt(GLint iLocation, int const& iValue)
 {
-	glUniform1i(glGetUniformLocation(m_program, iUniform.c_str()), iValue);
+	glUniform1i(iLocation, iValue);
 }
 
-void Shader::setFloat(std::string const& iUniform, float const& iValue)
+void Shader::setFloat(GLint iLocation, float const& iValue)
 {
-	glUniform1f(glGetUniformLocation(m_program, iUniform.c_str()), iValue);
+	glUniform1f(iLocation, iValue);
 }
 
-void Shader::setBool(std::string const& iUniform, bool const& iValue)
+void Shader::setBool(GLint iLocation, bool const& iValue)
 {
-	glUniform1i(glGetUniformLocation(m_program, iUniform.c_str()), iValue);
+	glUniform1i(iLocation, iValue);
 }
\ No newline at end of file
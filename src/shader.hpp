@@ -1,26 +1,63 @@
 #pragma once
 
+#include <cstdint>
 #include <sstream>
 #include <fstream>
 #include <string>
 #include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "GLCommon.h"
 
+// uniform buffer binding point of the Frame block
+constexpr GLuint g_frameUniformBinding = 0;
+
+// std140 mirror of the Frame block of shaders/frame_uniforms.glsl, uploaded once per frame
+struct FrameUniforms
+{
+	glm::mat4 m_model;
+	glm::mat4 m_view;
+	glm::mat4 m_proj;
+	glm::mat4 m_mvp;				// proj * view * model
+	glm::vec3 m_viewPosition;
+	float m_max_Kn;
+	glm::vec3 m_objectColor;
+	float m_minKg;
+	float m_maxKg;
+	float m_minH;
+	float m_maxH;
+	int m_padding;
+};
+static_assert(sizeof(FrameUniforms) == 304, "FrameUniforms must follow the std140 layout of the Frame block");
+
 std::string file2String(std::string const & iFile);
+// file content with every #include "file" line replaced by that file, relative to the including one
+std::string loadShaderSource(std::string const& iFile);
+// source with a #define line per entry ("NAME value") inserted right after its #version line
+std::string injectDefines(std::string const& iSource, std::vector<std::string> const& iDefines);
 
 struct Shader
 {
 	Shader() = delete;
-	Shader(std::string const& iVertex, std::string const& iFragment);
-	Shader(std::string const& iVertex, std::string const& iGeometry, std::string const& iFragment);
+	Shader(std::string const& iVertex, std::string const& iFragment, std::vector<std::string> const& iDefines = {});
+	Shader(std::string const& iVertex, std::string const& iGeometry, std::string const& iFragment, std::vector<std::string> const& iDefines = {});
 	~Shader();
+	void build(std::vector<std::pair<GLenum, std::string>> const& iStages, std::vector<std::string> const& iDefines);
+	bool loadProgramBinary(uint64_t iKey, double& oSourceBuildMs);
+	void saveProgramBinary(uint64_t iKey, double iSourceBuildMs) const;
 	void checkCompileError(GLuint const& iShader, GLenum iType);
 	bool checkLinkError();
-	void setMat4f(std::string const& iUniform, glm::mat4 const & iMat);
-	void setVec3f(std::string const& iUniform, glm::vec3 const& iVec);
-	void setInt(std::string const& iUniform, int const& iValue);
-	void setFloat(std::string const& iUniform, float const& iValue);
-	void setBool(std::string const& iUniform, bool const& iValue);
+	void reflectUniforms();
+	GLint uniformLocation(std::string const& iUniform) const;
+	// iLocation from uniformLocation, looked up once rather than for every call
+	void setMat4f(GLint iLocation, glm::mat4 const & iMat);
+	void setVec3f(GLint iLocation, glm::vec3 const& iVec);
+	void setInt(GLint iLocation, int const& iValue);
+	void setFloat(GLint iLocation, float const& iValue);
+	void setBool(GLint iLocation, bool const& iValue);
 
 	GLuint m_program;
+	std::string m_binaryPath;	// linked program cache, <fragment shader>.<program hash>.program
+	std::unordered_map<std::string, GLint> m_uniforms;	// locations of the default block uniforms
 };
\ No newline at end of file
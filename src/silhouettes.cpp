@@ -0,0 +1,184 @@
+#include "silhouettes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	constexpr size_t g_silhouetteGrain = 4096;
+
+	glm::vec3 safe_normalize(glm::vec3 const& iVector)
+	{
+		float length = glm::length(iVector);
+		return (length > 0.0f) ? iVector / length : glm::vec3(0.0f);
+	}
+
+	template<typename T>
+	void concatenate(std::vector<std::vector<T>> const& iBlocks, std::vector<T>& oResult)
+	{
+		size_t total = 0;
+		for (std::vector<T> const& block : iBlocks) { total += block.size(); }
+		oResult.clear();
+		oResult.reserve(total);
+		for (std::vector<T> const& block : iBlocks) { oResult.insert(oResult.end(), block.begin(), block.end()); }
+	}
+}
+
+void SilhouetteExtractor::build(std::vector<glm::vec3> const& iVertex, std::vector<glm::vec3> const& iNormal, CornerTable const& iCorners)
+{
+	m_corners = iCorners;
+	m_position = iVertex;
+
+	size_t vertex_count = iVertex.size();
+	m_normal.resize(vertex_count);
+	m_normal_offset.resize(vertex_count);
+	for (size_t i = 0; i < vertex_count; ++i)
+	{
+		m_normal[i] = safe_normalize(iNormal[i]);
+		m_normal_offset[i] = glm::dot(m_normal[i], iVertex[i]);
+	}
+
+	// same orientation as Geometry::compute_normals
+	size_t face_count = m_corners.m_corner_vertex.size() / 3;
+	m_face_normal.resize(face_count);
+	m_face_offset.resize(face_count);
+	for (size_t f = 0; f < face_count; ++f)
+	{
+		glm::vec3 const& a = iVertex[m_corners.vertex(3 * f)];
+		glm::vec3 const& b = iVertex[m_corners.vertex(3 * f + 1)];
+		glm::vec3 const& c = iVertex[m_corners.vertex(3 * f + 2)];
+		m_face_normal[f] = safe_normalize(glm::cross(b - a, c - a));
+		m_face_offset[f] = glm::dot(m_face_normal[f], a);
+	}
+
+	// bounding sphere around the box center
+	glm::vec3 min_corner(std::numeric_limits<float>::max());
+	glm::vec3 max_corner(-std::numeric_limits<float>::max());
+	for (glm::vec3 const& v : iVertex)
+	{
+		min_corner = glm::min(min_corner, v);
+		max_corner = glm::max(max_corner, v);
+	}
+	glm::vec3 center = (vertex_count > 0) ? 0.5f * (min_corner + max_corner) : glm::vec3(0.0f);
+	m_radius = 0.0f;
+	for (glm::vec3 const& v : iVertex) { m_radius = std::max(m_radius, glm::length(v - center)); }
+	if (m_radius == 0.0f) { m_radius = 1.0f; }
+
+	// the next extract is a full pass
+	m_has_view = false;
+	m_candidate.clear();
+	m_is_candidate.assign(face_count, 0);
+}
+
+void SilhouetteExtractor::extract(ThreadPool& iPool, glm::vec3 const& iViewPosition, int iFamilies, std::vector<glm::vec3>& oEdgeSegment, std::vector<glm::vec3>& oSmoothSegment)
+{
+	size_t face_count = m_face_normal.size();
+	float band = m_band * m_radius;
+	bool edges = (iFamilies & SF_EDGE) != 0;
+	bool smooth_silhouettes = (iFamilies & SF_SMOOTH) != 0;
+	bool full = !m_has_view || glm::length(iViewPosition - m_full_view) >= band || (iFamilies & ~m_full_families) != 0;
+	size_t count = full ? face_count : m_candidate.size();
+
+	size_t block_count = (count + g_silhouetteGrain - 1) / g_silhouetteGrain;
+	m_block_edge.resize(block_count);
+	m_block_smooth.resize(block_count);
+	if (full) { m_block_candidate.resize(block_count); }
+
+	auto face_value = [&](int f) { return glm::dot(m_face_normal[f], iViewPosition) - m_face_offset[f]; };
+	auto vertex_value = [&](int v) { return glm::dot(m_normal[v], iViewPosition) - m_normal_offset[v]; };
+
+	iPool.parallel_for(0, count, g_silhouetteGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		size_t block = iBegin / g_silhouetteGrain;
+		std::vector<glm::vec3>& edge = m_block_edge[block];
+		std::vector<glm::vec3>& smooth = m_block_smooth[block];
+		edge.clear();
+		smooth.clear();
+		if (full) { m_block_candidate[block].clear(); }
+
+		for (size_t k = iBegin; k < iEnd; ++k)
+		{
+			int f = full ? static_cast<int>(k) : m_candidate[k];
+			bool keep = false;
+
+			// ========== edge silhouettes, an interior edge is emitted by its smallest face among the tested ones
+			if (edges)
+			{
+				float value = face_value(f);
+				bool front = value > 0.0f;
+				keep = std::abs(value) <= band;
+				for (int c = 0; c < 3; ++c)
+				{
+					int corner = 3 * f + c;
+					int g = m_corners.opposite_face(corner);
+					bool silhouette = front;
+					if (g == -1)
+					{
+						keep = true;
+					}
+					else
+					{
+						silhouette = front != (face_value(g) > 0.0f);
+						keep = keep || silhouette;
+						if ((full || m_is_candidate[g]) && g < f) { silhouette = false; }
+					}
+					if (silhouette)
+					{
+						int a = m_corners.vertex(CornerTable::next(corner));
+						int b = m_corners.vertex(CornerTable::prev(corner));
+						if (b < a) { std::swap(a, b); }
+						edge.push_back(m_position[a]);
+						edge.push_back(m_position[b]);
+					}
+				}
+			}
+
+			// ========== smooth silhouette, the segment joining the two edge crossings of n.v
+			if (smooth_silhouettes)
+			{
+				int vertex[3];
+				float n_dot_v[3];
+				bool negative[3];
+				for (int c = 0; c < 3; ++c)
+				{
+					vertex[c] = m_corners.vertex(3 * f + c);
+					n_dot_v[c] = vertex_value(vertex[c]);
+					negative[c] = n_dot_v[c] < 0.0f;
+					keep = keep || std::abs(n_dot_v[c]) <= band;
+				}
+				if (negative[0] != negative[1] || negative[1] != negative[2])
+				{
+					keep = true;
+
+					// the corner alone on its side of the zero set, each crossing in the same order from both faces of its edge
+					int a = (negative[0] != negative[1] && negative[0] != negative[2]) ? 0 : (negative[0] == negative[2]) ? 1 : 2;
+					for (int side : { 1, 2 })
+					{
+						int i = a;
+						int j = (a + side) % 3;
+						if (vertex[j] < vertex[i]) { std::swap(i, j); }
+						float t = n_dot_v[i] / (n_dot_v[i] - n_dot_v[j]);
+						smooth.push_back(m_position[vertex[i]] + t * (m_position[vertex[j]] - m_position[vertex[i]]));
+					}
+				}
+			}
+
+			if (full && keep) { m_block_candidate[block].push_back(f); }
+		}
+	});
+
+	if (full)
+	{
+		concatenate(m_block_candidate, m_candidate);
+		m_is_candidate.assign(face_count, 0);
+		for (int f : m_candidate) { m_is_candidate[f] = 1; }
+		m_full_view = iViewPosition;
+		m_full_families = iFamilies;
+		m_has_view = true;
+	}
+	m_tested_faces = count;
+
+	concatenate(m_block_edge, oEdgeSegment);
+	concatenate(m_block_smooth, oSmoothSegment);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "thread_pool.hpp"
+#include "topology.hpp"
+
+// silhouettes seen from a viewpoint :
+// - edge silhouettes, the mesh edges between a front and a back face, plus the boundary edges of front faces
+// - smooth silhouettes, the zero crossings of n.v interpolated from the vertex normals inside each face
+//
+// The test values n.E - n.p of the faces and vertices move by at most |dE| when the camera moves
+// by dE, unit normals. A full pass keeps the faces where one of them is within m_band r of zero,
+// r being the bounding radius, or that already hold a silhouette : until the camera is m_band r away
+// from the viewpoint of that pass, no other face can hold one and only those faces are tested again.
+// Segment ends are ordered by vertex index, so both passes give the same segments.
+// Only the families asked for are extracted and kept as candidates, asking for another
+// family than the last full pass starts a new one.
+enum SILHOUETTE_FAMILY
+{
+	SF_EDGE = 1,
+	SF_SMOOTH = 2
+};
+
+struct SilhouetteExtractor
+{
+	void build(std::vector<glm::vec3> const& iVertex, std::vector<glm::vec3> const& iNormal, CornerTable const& iCorners);
+	// pairs of segment ends in object space, iViewPosition is the camera in object space,
+	// iFamilies a combination of SILHOUETTE_FAMILY, the other output is left empty
+	void extract(ThreadPool& iPool, glm::vec3 const& iViewPosition, int iFamilies, std::vector<glm::vec3>& oEdgeSegment, std::vector<glm::vec3>& oSmoothSegment);
+
+	float m_band = 0.1f;			// camera motion before a full pass, relative to the bounding radius
+	float m_radius = 1.0f;
+
+	CornerTable m_corners;						// boundary edges have no opposite face
+	std::vector<glm::vec3> m_position;
+	std::vector<glm::vec3> m_normal;			// unit vertex normals
+	std::vector<float> m_normal_offset;			// n.p of every vertex
+	std::vector<glm::vec3> m_face_normal;		// unit face normals
+	std::vector<float> m_face_offset;			// n.p of every face
+
+	// faces tested until the next full pass, in face order
+	bool m_has_view = false;
+	glm::vec3 m_full_view;						// viewpoint of the last full pass
+	int m_full_families = 0;					// families of the last full pass
+	std::vector<int> m_candidate;
+	std::vector<unsigned char> m_is_candidate;
+	size_t m_tested_faces = 0;					// by the last extract
+
+	std::vector<std::vector<glm::vec3>> m_block_edge;
+	std::vector<std::vector<glm::vec3>> m_block_smooth;
+	std::vector<std::vector<int>> m_block_candidate;
+};
@@ -0,0 +1,295 @@
+#include "taubin.hpp"
+
+#include <algorithm>
+
+using Lanes = Eigen::Array<float, g_taubinLanes, 1>;
+using SparseRowMatrix = Eigen::SparseMatrix<float, Eigen::RowMajor>;
+
+void PositionBuffer::resize(size_t iSize)
+{
+	m_x.resize(iSize);
+	m_y.resize(iSize);
+	m_z.resize(iSize);
+}
+
+static void to_position_buffer(std::vector<glm::vec3> const& iVertex, PositionBuffer& oBuffer)
+{
+	oBuffer.resize(iVertex.size());
+	for (size_t i = 0; i < iVertex.size(); ++i)
+	{
+		oBuffer.m_x[i] = iVertex[i].x;
+		oBuffer.m_y[i] = iVertex[i].y;
+		oBuffer.m_z[i] = iVertex[i].z;
+	}
+}
+
+static void from_position_buffer(PositionBuffer const& iBuffer, std::vector<glm::vec3>& oVertex)
+{
+	for (size_t i = 0; i < oVertex.size(); ++i)
+	{
+		oVertex[i] = glm::vec3(iBuffer.m_x[i], iBuffer.m_y[i], iBuffer.m_z[i]);
+	}
+}
+
+// x'_i = x_i - scale (x_i - sum_j w_ij x_j) for a single vertex
+static void taubin_vertex(SparseRowMatrix const& iW, float iScale, PositionBuffer const& iIn, PositionBuffer& oOut, size_t i)
+{
+	int const* outer = iW.outerIndexPtr();
+	int const* inner = iW.innerIndexPtr();
+	float const* value = iW.valuePtr();
+
+	float ax = 0.0f;
+	float ay = 0.0f;
+	float az = 0.0f;
+	for (int e = outer[i]; e < outer[i + 1]; ++e)
+	{
+		int j = inner[e];
+		float w = value[e];
+		ax += w * iIn.m_x[j];
+		ay += w * iIn.m_y[j];
+		az += w * iIn.m_z[j];
+	}
+
+	float x = iIn.m_x[i];
+	float y = iIn.m_y[i];
+	float z = iIn.m_z[i];
+	oOut.m_x[i] = x - iScale * (x - ax);
+	oOut.m_y[i] = y - iScale * (y - ay);
+	oOut.m_z[i] = z - iScale * (z - az);
+}
+
+// rows of W split into slices of g_taubinLanes rows, each slice padded to its longest row and
+// stored neighbor-major so that one neighbor of every row of the slice is contiguous.
+// Columns are positions in the buffer read by the pass, padding entries point to the
+// row itself with a zero weight. m_self and m_target are the positions of each row in
+// the buffers read and written by the pass, m_contiguous flags the full slices where both
+// are runs of consecutive positions.
+struct SlicedWeights
+{
+	size_t m_rows = 0;
+	std::vector<int> m_offset;
+	std::vector<int> m_degree;
+	std::vector<int> m_index;
+	std::vector<float> m_weight;
+	std::vector<int> m_self;
+	std::vector<int> m_target;
+	std::vector<unsigned char> m_contiguous;
+};
+
+// iRows are rows of W, iColumn maps a column of W to its position in the read buffer
+template<typename ColumnMap>
+static void build_sliced_weights(SparseRowMatrix const& iW, std::vector<int> const& iRows, ColumnMap const& iColumn,
+	std::vector<int> iSelf, std::vector<int> iTarget, SlicedWeights& oSlices)
+{
+	int const* outer = iW.outerIndexPtr();
+	int const* inner = iW.innerIndexPtr();
+	float const* value = iW.valuePtr();
+	size_t rows = iRows.size();
+	size_t slice_count = (rows + g_taubinLanes - 1) / g_taubinLanes;
+
+	oSlices.m_rows = rows;
+	oSlices.m_offset.resize(slice_count + 1);
+	oSlices.m_degree.resize(slice_count);
+	oSlices.m_contiguous.resize(slice_count);
+	oSlices.m_offset[0] = 0;
+	for (size_t s = 0; s < slice_count; ++s)
+	{
+		size_t first = s * g_taubinLanes;
+		bool contiguous = first + g_taubinLanes <= rows;
+		for (size_t l = 1; contiguous && l < g_taubinLanes; ++l)
+		{
+			contiguous = iSelf[first + l] == iSelf[first] + static_cast<int>(l) && iTarget[first + l] == iTarget[first] + static_cast<int>(l);
+		}
+		oSlices.m_contiguous[s] = contiguous;
+
+		int degree = 0;
+		for (size_t r = s * g_taubinLanes; r < std::min(rows, (s + 1) * g_taubinLanes); ++r)
+		{
+			degree = std::max(degree, outer[iRows[r] + 1] - outer[iRows[r]]);
+		}
+		oSlices.m_degree[s] = degree;
+		oSlices.m_offset[s + 1] = oSlices.m_offset[s] + degree * g_taubinLanes;
+	}
+
+	oSlices.m_index.resize(oSlices.m_offset[slice_count]);
+	oSlices.m_weight.resize(oSlices.m_offset[slice_count]);
+	for (size_t s = 0; s < slice_count; ++s)
+	{
+		for (int l = 0; l < g_taubinLanes; ++l)
+		{
+			size_t r = std::min(s * g_taubinLanes + l, rows - 1);
+			int i = iRows[r];
+			int degree = (s * g_taubinLanes + l < rows) ? outer[i + 1] - outer[i] : 0;
+			int* index = oSlices.m_index.data() + oSlices.m_offset[s] + l;
+			float* weight = oSlices.m_weight.data() + oSlices.m_offset[s] + l;
+			for (int k = 0; k < oSlices.m_degree[s]; ++k)
+			{
+				index[k * g_taubinLanes] = (k < degree) ? iColumn(inner[outer[i] + k]) : iSelf[r];
+				weight[k * g_taubinLanes] = (k < degree) ? value[outer[i] + k] : 0.0f;
+			}
+		}
+	}
+	oSlices.m_self = std::move(iSelf);
+	oSlices.m_target = std::move(iTarget);
+}
+
+// same computation as taubin_vertex on g_taubinLanes rows at once, lanes with
+// fewer neighbors accumulate 0 * x_i which leaves their sums unchanged
+static void taubin_pass(SlicedWeights const& iSlices, float iScale, PositionBuffer const& iIn, PositionBuffer& oOut)
+{
+	for (size_t s = 0; s < iSlices.m_degree.size(); ++s)
+	{
+		int const* index = iSlices.m_index.data() + iSlices.m_offset[s];
+		float const* weight = iSlices.m_weight.data() + iSlices.m_offset[s];
+
+		Lanes ax = Lanes::Zero();
+		Lanes ay = Lanes::Zero();
+		Lanes az = Lanes::Zero();
+		for (int k = 0; k < iSlices.m_degree[s]; ++k)
+		{
+			Lanes gx;
+			Lanes gy;
+			Lanes gz;
+			for (int l = 0; l < g_taubinLanes; ++l)
+			{
+				int j = index[l];
+				gx[l] = iIn.m_x[j];
+				gy[l] = iIn.m_y[j];
+				gz[l] = iIn.m_z[j];
+			}
+			Lanes w = Eigen::Map<Lanes const>(weight);
+			ax += w * gx;
+			ay += w * gy;
+			az += w * gz;
+			index += g_taubinLanes;
+			weight += g_taubinLanes;
+		}
+
+		size_t first = s * g_taubinLanes;
+		if (iSlices.m_contiguous[s])
+		{
+			int i = iSlices.m_self[first];
+			int o = iSlices.m_target[first];
+			Lanes x = Eigen::Map<Lanes const>(&iIn.m_x[i]);
+			Lanes y = Eigen::Map<Lanes const>(&iIn.m_y[i]);
+			Lanes z = Eigen::Map<Lanes const>(&iIn.m_z[i]);
+			Eigen::Map<Lanes>(&oOut.m_x[o]) = x - iScale * (x - ax);
+			Eigen::Map<Lanes>(&oOut.m_y[o]) = y - iScale * (y - ay);
+			Eigen::Map<Lanes>(&oOut.m_z[o]) = z - iScale * (z - az);
+			continue;
+		}
+
+		size_t lanes = std::min<size_t>(g_taubinLanes, iSlices.m_rows - first);
+		Lanes x;
+		Lanes y;
+		Lanes z;
+		for (int l = 0; l < g_taubinLanes; ++l)
+		{
+			int i = iSlices.m_self[first + std::min<size_t>(l, lanes - 1)];
+			x[l] = iIn.m_x[i];
+			y[l] = iIn.m_y[i];
+			z[l] = iIn.m_z[i];
+		}
+		x -= iScale * (x - ax);
+		y -= iScale * (y - ay);
+		z -= iScale * (z - az);
+		for (size_t l = 0; l < lanes; ++l)
+		{
+			int i = iSlices.m_target[first + l];
+			oOut.m_x[i] = x[l];
+			oOut.m_y[i] = y[l];
+			oOut.m_z[i] = z[l];
+		}
+	}
+}
+
+void taubin_smoothing_kernel(ThreadPool& iPool, SparseRowMatrix const& iW,
+	float iLambda, float iMu, unsigned int iN, std::vector<glm::vec3>& ioVertex)
+{
+	size_t count = ioVertex.size();
+	PositionBuffer front[2];
+	to_position_buffer(ioVertex, front[0]);
+	front[1].resize(count);
+
+	// the mu pass of a vertex needs the lambda pass of its one-ring : each thread runs the
+	// lambda pass on its vertices and their one-ring into a buffer of its own, then the mu
+	// pass on its vertices, and only waits for the others once per pair of passes
+	Barrier barrier(iPool.size());
+	iPool.run([&](unsigned int iThread, unsigned int iThreadCount)
+	{
+		size_t range = (count + iThreadCount - 1) / iThreadCount;
+		range = ((range + g_taubinLanes - 1) / g_taubinLanes) * g_taubinLanes;
+		size_t begin = std::min(count, iThread * range);
+		size_t end = std::min(count, begin + range);
+
+		// vertices of the lambda pass : the range, then the vertices of its one-ring outside of it
+		int const* outer = iW.outerIndexPtr();
+		int const* inner = iW.innerIndexPtr();
+		std::vector<int> halo;
+		for (int e = outer[begin]; e < outer[end]; ++e)
+		{
+			if (inner[e] < static_cast<int>(begin) || inner[e] >= static_cast<int>(end)) { halo.push_back(inner[e]); }
+		}
+		std::sort(halo.begin(), halo.end());
+		halo.erase(std::unique(halo.begin(), halo.end()), halo.end());
+		auto local_position = [&](int j)
+		{
+			if (j >= static_cast<int>(begin) && j < static_cast<int>(end)) { return j - static_cast<int>(begin); }
+			return static_cast<int>(end - begin + (std::lower_bound(halo.begin(), halo.end(), j) - halo.begin()));
+		};
+
+		std::vector<int> rows(end - begin);
+		for (size_t i = begin; i < end; ++i) { rows[i - begin] = static_cast<int>(i); }
+		std::vector<int> local = rows;
+		local.insert(local.end(), halo.begin(), halo.end());
+		std::vector<int> positions(local.size());
+		for (size_t k = 0; k < local.size(); ++k) { positions[k] = static_cast<int>(k); }
+
+		SlicedWeights lambda_slices;
+		build_sliced_weights(iW, local, [](int j) { return j; }, local, positions, lambda_slices);
+		// without a halo from the first vertex on, both passes read and write the same positions
+		SlicedWeights mu_slices;
+		SlicedWeights const* mu = &lambda_slices;
+		if (!halo.empty() || begin != 0)
+		{
+			positions.resize(rows.size());
+			build_sliced_weights(iW, rows, local_position, positions, rows, mu_slices);
+			mu = &mu_slices;
+		}
+
+		PositionBuffer shrunk;
+		shrunk.resize(local.size());
+		for (unsigned int n = 0; n < iN; ++n)
+		{
+			taubin_pass(lambda_slices, iLambda, front[n % 2], shrunk);
+			taubin_pass(*mu, iMu, shrunk, front[(n + 1) % 2]);
+			barrier.wait();
+		}
+	});
+
+	from_position_buffer(front[iN % 2], ioVertex);
+}
+
+void taubin_smoothing_reference(SparseRowMatrix const& iW,
+	float iLambda, float iMu, unsigned int iN, std::vector<glm::vec3>& ioVertex)
+{
+	size_t count = ioVertex.size();
+	PositionBuffer front;
+	PositionBuffer back;
+	to_position_buffer(ioVertex, front);
+	back.resize(count);
+
+	for (unsigned int n = 0; n < iN; ++n)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			taubin_vertex(iW, iLambda, front, back, i);
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			taubin_vertex(iW, iMu, back, front, i);
+		}
+	}
+
+	from_position_buffer(front, ioVertex);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <Eigen/Sparse>
+#include <glm/glm.hpp>
+#include "thread_pool.hpp"
+
+// vertices processed together by the smoothing kernel
+constexpr int g_taubinLanes = 8;
+
+// positions stored as separate x, y and z arrays
+struct PositionBuffer
+{
+	void resize(size_t iSize);
+
+	std::vector<float> m_x;
+	std::vector<float> m_y;
+	std::vector<float> m_z;
+};
+
+// N pairs of Taubin passes x' = x - scale (x - W x), with scale = lambda then mu.
+// W is the row-stochastic one-ring weight matrix, so K = I - W is never formed.
+// Each thread owns a fixed range of vertices and runs the lambda pass on it and its one-ring,
+// then the mu pass on it : the threads only wait for each other once per pair. Every vertex
+// is computed the same way by any thread, so the result does not depend on the thread count.
+void taubin_smoothing_kernel(ThreadPool& iPool, Eigen::SparseMatrix<float, Eigen::RowMajor> const& iW,
+	float iLambda, float iMu, unsigned int iN, std::vector<glm::vec3>& ioVertex);
+
+// single threaded scalar version, bit for bit identical to taubin_smoothing_kernel
+void taubin_smoothing_reference(Eigen::SparseMatrix<float, Eigen::RowMajor> const& iW,
+	float iLambda, float iMu, unsigned int iN, std::vector<glm::vec3>& ioVertex);
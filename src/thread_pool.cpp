@@ -0,0 +1,129 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(unsigned int iThreadCount) :
+	m_task(nullptr),
+	m_generation(0),
+	m_pending(0),
+	m_stop(false)
+{
+	for (unsigned int i = 1; i < iThreadCount; ++i)
+	{
+		m_workers.emplace_back(&ThreadPool::worker, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (std::thread& t : m_workers)
+	{
+		t.join();
+	}
+}
+
+void ThreadPool::worker(unsigned int iIndex)
+{
+	unsigned int generation = 0;
+	while (true)
+	{
+		std::function<void(unsigned int, unsigned int)> const* task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&]() { return m_stop || m_generation != generation; });
+			if (m_stop) { return; }
+			generation = m_generation;
+			task = m_task;
+		}
+
+		(*task)(iIndex, size());
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_pending == 0) { m_done.notify_one(); }
+		}
+	}
+}
+
+void ThreadPool::run(std::function<void(unsigned int, unsigned int)> const& iTask)
+{
+	if (m_workers.empty())
+	{
+		iTask(0, 1);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &iTask;
+		m_pending = static_cast<unsigned int>(m_workers.size());
+		++m_generation;
+	}
+	m_wake.notify_all();
+
+	iTask(0, size());
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [&]() { return m_pending == 0; });
+}
+
+void ThreadPool::parallel_for(size_t iBegin, size_t iEnd, size_t iGrain, std::function<void(size_t, size_t)> const& iTask)
+{
+	if (iEnd <= iBegin) { return; }
+
+	// blocks never exceed iGrain elements, even when run on the calling thread alone
+	size_t block_count = (iEnd - iBegin + iGrain - 1) / iGrain;
+	auto run_block = [&](size_t b)
+	{
+		size_t begin = iBegin + b * iGrain;
+		size_t end = (begin + iGrain < iEnd) ? begin + iGrain : iEnd;
+		iTask(begin, end);
+	};
+
+	if (block_count == 1 || m_workers.empty())
+	{
+		for (size_t b = 0; b < block_count; ++b)
+		{
+			run_block(b);
+		}
+		return;
+	}
+
+	std::atomic<size_t> next_block(0);
+	run([&](unsigned int, unsigned int)
+	{
+		for (size_t b = next_block++; b < block_count; b = next_block++)
+		{
+			run_block(b);
+		}
+	});
+}
+
+ThreadPool& ThreadPool::global()
+{
+	static ThreadPool pool(std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1);
+	return pool;
+}
+
+Barrier::Barrier(unsigned int iCount) :
+	m_count(iCount),
+	m_waiting(0),
+	m_generation(0)
+{}
+
+void Barrier::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	unsigned int generation = m_generation;
+	if (++m_waiting == m_count)
+	{
+		m_waiting = 0;
+		++m_generation;
+		m_cv.notify_all();
+		return;
+	}
+	m_cv.wait(lock, [&]() { return m_generation != generation; });
+}
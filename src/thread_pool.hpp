@@ -0,0 +1,51 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <vector>
+
+// fixed set of worker threads, the calling thread takes part in every job.
+// Jobs must be submitted from a single thread and must not submit jobs themselves.
+struct ThreadPool
+{
+	ThreadPool(unsigned int iThreadCount);
+	~ThreadPool();
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+	// run iTask(thread_index, thread_count) once on every thread and wait for all of them
+	void run(std::function<void(unsigned int, unsigned int)> const& iTask);
+	// split [iBegin, iEnd) into blocks of iGrain elements, blocks are handed out to the threads
+	void parallel_for(size_t iBegin, size_t iEnd, size_t iGrain, std::function<void(size_t, size_t)> const& iTask);
+	unsigned int size() const { return static_cast<unsigned int>(m_workers.size()) + 1; }
+
+	// pool shared by the geometry processing, one thread per core
+	static ThreadPool& global();
+
+	void worker(unsigned int iIndex);
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	std::function<void(unsigned int, unsigned int)> const* m_task;
+	unsigned int m_generation;
+	unsigned int m_pending;
+	bool m_stop;
+};
+
+// reusable barrier between the threads of a ThreadPool::run job
+struct Barrier
+{
+	Barrier(unsigned int iCount);
+	void wait();
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	unsigned int m_count;
+	unsigned int m_waiting;
+	unsigned int m_generation;
+};
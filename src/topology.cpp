@@ -0,0 +1,117 @@
+#include "topology.hpp"
+
+void CornerTable::build(std::vector<glm::ivec3> const& iFaces, size_t iVertexCount)
+{
+	size_t corner_count = 3 * iFaces.size();
+	m_corner_vertex.resize(corner_count);
+	for (size_t f = 0; f < iFaces.size(); ++f)
+	{
+		m_corner_vertex[3 * f] = iFaces[f].x;
+		m_corner_vertex[3 * f + 1] = iFaces[f].y;
+		m_corner_vertex[3 * f + 2] = iFaces[f].z;
+	}
+
+	// vertex -> corners : counting sort of the corners by vertex
+	std::vector<int>& offset = m_vertex_corners.m_offset;
+	offset.assign(iVertexCount + 1, 0);
+	for (size_t c = 0; c < corner_count; ++c)
+	{
+		++offset[m_corner_vertex[c] + 1];
+	}
+	for (size_t i = 0; i < iVertexCount; ++i)
+	{
+		offset[i + 1] += offset[i];
+	}
+
+	std::vector<int> cursor(offset.begin(), offset.end() - 1);
+	m_vertex_corners.m_index.resize(corner_count);
+	for (size_t c = 0; c < corner_count; ++c)
+	{
+		m_vertex_corners.m_index[cursor[m_corner_vertex[c]]++] = c;
+	}
+
+	// opposite corners : the edge a -> b facing corner c is shared with the face
+	// holding b -> a, found among the corners of b. Edges used more than once
+	// in the same direction are non-manifold and left unlinked, like boundary edges.
+	auto count_edges = [this](int a, int b, int& oCorner)
+	{
+		int count = 0;
+		for (int const& k : m_vertex_corners[a])
+		{
+			if (m_corner_vertex[next(k)] == b)
+			{
+				oCorner = prev(k);
+				++count;
+			}
+		}
+		return count;
+	};
+
+	m_opposite.assign(corner_count, -1);
+	for (size_t c = 0; c < corner_count; ++c)
+	{
+		if (m_opposite[c] != -1) { continue; }
+
+		int a = m_corner_vertex[next(c)];
+		int b = m_corner_vertex[prev(c)];
+		int corner = -1;
+		int twin = -1;
+		if (a != b && count_edges(a, b, corner) == 1 && count_edges(b, a, twin) == 1)
+		{
+			m_opposite[c] = twin;
+			m_opposite[twin] = c;
+		}
+	}
+}
+
+bool CornerTable::is_boundary_vertex(int v) const
+{
+	for (int const& c : m_vertex_corners[v])
+	{
+		if (m_opposite[next(c)] == -1 || m_opposite[prev(c)] == -1)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+CornerTable::OneRing CornerTable::one_ring(int v) const
+{
+	IndexRange corners = m_vertex_corners[v];
+	if (corners.size() == 0)
+	{
+		return OneRing{ this, -1 };
+	}
+
+	// on a boundary, start from the corner that cannot be swung backward
+	// so that the walk covers the whole fan
+	int first = *corners.begin();
+	int start = first;
+	for (int c = unswing(first); c != -1; c = unswing(c))
+	{
+		// closed fan
+		if (c == first) { return OneRing{ this, first }; }
+		start = c;
+	}
+	return OneRing{ this, start };
+}
+
+int CornerTable::edge_corner(int a, int b) const
+{
+	for (int const& k : m_vertex_corners[a])
+	{
+		if (m_corner_vertex[next(k)] == b)
+		{
+			return prev(k);
+		}
+	}
+	return -1;
+}
+
+std::array<int, 2> CornerTable::edge_faces(int a, int b) const
+{
+	int c0 = edge_corner(a, b);
+	int c1 = edge_corner(b, a);
+	return { (c0 == -1) ? -1 : face(c0), (c1 == -1) ? -1 : face(c1) };
+}
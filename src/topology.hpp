@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <glm/glm.hpp>
+
+struct IndexRange
+{
+	int const* m_begin;
+	int const* m_end;
+
+	int const* begin() const { return m_begin; }
+	int const* end() const { return m_end; }
+	size_t size() const { return m_end - m_begin; }
+};
+
+// compressed adjacency : neighbors of element i are stored in
+// m_index[m_offset[i]] up to m_index[m_offset[i + 1]] (excluded)
+struct Adjacency
+{
+	std::vector<int> m_offset;
+	std::vector<int> m_index;
+
+	IndexRange operator[](size_t i) const
+	{
+		int const* data = m_index.data();
+		return IndexRange{ data + m_offset[i], data + m_offset[i + 1] };
+	}
+};
+
+// corner table : corner c is the (c % 3)-th corner of face c / 3,
+// its opposite corner is the corner facing the same edge in the neighboring face
+// (-1 when that edge is a boundary or non-manifold edge)
+struct CornerTable
+{
+	// ========== ordered traversal of the faces around a vertex
+	struct OneRing
+	{
+		struct Iterator
+		{
+			CornerTable const* m_table;
+			int m_start;
+			int m_corner;
+
+			int operator*() const { return m_corner; }
+			bool operator!=(Iterator const& iOther) const { return m_corner != iOther.m_corner; }
+			Iterator& operator++()
+			{
+				m_corner = m_table->swing(m_corner);
+				if (m_corner == m_start) { m_corner = -1; }
+				return *this;
+			}
+		};
+
+		Iterator begin() const { return Iterator{ m_table, m_start, m_start }; }
+		Iterator end() const { return Iterator{ m_table, m_start, -1 }; }
+
+		CornerTable const* m_table;
+		int m_start;
+	};
+
+	void build(std::vector<glm::ivec3> const& iFaces, size_t iVertexCount);
+
+	// ========== corner navigation
+	static int face(int c) { return c / 3; }
+	static int next(int c) { return (c % 3 == 2) ? c - 2 : c + 1; }
+	static int prev(int c) { return (c % 3 == 0) ? c + 2 : c - 1; }
+	int vertex(int c) const { return m_corner_vertex[c]; }
+	int opposite(int c) const { return m_opposite[c]; }
+	// face across the edge facing corner c (-1 on a boundary or non-manifold edge)
+	int opposite_face(int c) const { return (m_opposite[c] == -1) ? -1 : face(m_opposite[c]); }
+
+	// corner of the same vertex in the next face around it (-1 on a boundary)
+	int swing(int c) const
+	{
+		int o = m_opposite[prev(c)];
+		return (o == -1) ? -1 : prev(o);
+	}
+	int unswing(int c) const
+	{
+		int o = m_opposite[next(c)];
+		return (o == -1) ? -1 : next(o);
+	}
+	// an earlier corner of the same face is on the same vertex : per vertex gathers skip it to count each face once
+	bool repeats_vertex(int c) const
+	{
+		int first = 3 * face(c);
+		return (c > first && m_corner_vertex[first] == m_corner_vertex[c]) || (c == first + 2 && m_corner_vertex[first + 1] == m_corner_vertex[c]);
+	}
+
+	// ========== vertex queries
+	IndexRange corners(size_t v) const { return m_vertex_corners[v]; }
+	bool is_boundary_vertex(int v) const;
+	// corners of v in swing order, from the first face of the fan on a boundary. Only the fan
+	// of the first corner is walked around a non-manifold vertex, corners(v) lists them all.
+	OneRing one_ring(int v) const;
+
+	// ========== edge queries
+	// corner facing the directed edge a -> b (-1 when no face holds it)
+	int edge_corner(int a, int b) const;
+	// faces holding a -> b and b -> a (-1 when missing)
+	std::array<int, 2> edge_faces(int a, int b) const;
+
+	std::vector<int> m_corner_vertex;	// vertex of each corner
+	std::vector<int> m_opposite;		// opposite corner of each corner
+	struct Adjacency m_vertex_corners;	// corners of each vertex, in face order
+};
@@ -0,0 +1,65 @@
+#include "vertex_format.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+	constexpr size_t g_packGrain = 4096;
+
+	uint32_t pack_direction(glm::vec3 const& iDirection)
+	{
+		return glm::packSnorm2x16(octahedral_encode(iDirection));
+	}
+}
+
+glm::vec2 octahedral_encode(glm::vec3 const& iDirection)
+{
+	float l1 = std::abs(iDirection.x) + std::abs(iDirection.y) + std::abs(iDirection.z);
+	if (!(l1 > 0.0f) || !std::isfinite(l1)) { return glm::vec2(0.0f); }
+
+	glm::vec3 d = iDirection / l1;
+	if (d.z >= 0.0f) { return glm::vec2(d.x, d.y); }
+
+	// lower hemisphere : fold the triangles over the diagonals of the square
+	return glm::vec2((1.0f - std::abs(d.y)) * std::copysign(1.0f, d.x), (1.0f - std::abs(d.x)) * std::copysign(1.0f, d.y));
+}
+
+glm::vec3 octahedral_decode(glm::vec2 const& iCode)
+{
+	glm::vec3 d(iCode.x, iCode.y, 1.0f - std::abs(iCode.x) - std::abs(iCode.y));
+	float t = std::max(-d.z, 0.0f);
+	d.x += (d.x >= 0.0f) ? -t : t;
+	d.y += (d.y >= 0.0f) ? -t : t;
+	return glm::normalize(d);
+}
+
+PackedVertex pack_vertex(glm::vec3 const& iPosition, glm::vec3 const& iNormal, glm::vec3 const& iTangentU, glm::vec3 const& iT1, glm::vec3 const& iT2,
+	float iK1, float iK2, glm::mat2 const& iC1, glm::mat2 const& iC2)
+{
+	PackedVertex v;
+	v.m_position = iPosition;
+	v.m_normal = pack_direction(iNormal);
+	v.m_tangent_u = pack_direction(iTangentU);
+	v.m_t1 = pack_direction(iT1);
+	v.m_t2 = pack_direction(iT2);
+	v.m_K = glm::packHalf2x16(glm::vec2(iK1, iK2));
+
+	// C1 = [[a, b], [b, c]], C2 = [[b, c], [c, d]]
+	v.m_C[0] = glm::packHalf2x16(glm::vec2(iC1[0][0], iC1[0][1]));
+	v.m_C[1] = glm::packHalf2x16(glm::vec2(iC1[1][1], iC2[1][1]));
+	return v;
+}
+
+void pack_vertices(ThreadPool& iPool, VertexStreams const& iStreams, PackedVertex* oVertex)
+{
+	iPool.parallel_for(0, iStreams.m_vertex_count, g_packGrain, [&](size_t iBegin, size_t iEnd)
+	{
+		for (size_t i = iBegin; i < iEnd; ++i)
+		{
+			oVertex[i] = pack_vertex(iStreams.m_position[i], iStreams.m_normal[i], iStreams.m_tangent_u[i], iStreams.m_t1[i], iStreams.m_t2[i],
+				iStreams.m_K1[i], iStreams.m_K2[i], iStreams.m_C1[i], iStreams.m_C2[i]);
+		}
+	});
+}
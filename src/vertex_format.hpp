@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "thread_pool.hpp"
+#include "curvature_cache.hpp"
+
+// interleaved GPU vertex, 40 bytes. Unit vectors are octahedral encoded on two snorm16,
+// the principal curvatures and the 4 independent coefficients of the symmetric C tensor
+// are half floats. The second tangent is not stored : (U, V, N) is direct so V = N x U.
+struct PackedVertex
+{
+	glm::vec3 m_position;		// location 0
+	uint32_t m_normal;			// location 1
+	uint32_t m_tangent_u;		// location 2
+	uint32_t m_t1;				// location 6
+	uint32_t m_t2;				// location 7
+	uint32_t m_K;				// location 4 : K1, K2
+	uint32_t m_C[2];			// location 8 : a, b, c, d with C1 = [[a, b], [b, c]] and C2 = [[b, c], [c, d]]
+};
+static_assert(sizeof(PackedVertex) == 40, "PackedVertex must match the vertex attribute layout");
+
+// unit vector folded onto the [-1, 1]^2 square, a zero or invalid vector gives +z
+glm::vec2 octahedral_encode(glm::vec3 const& iDirection);
+glm::vec3 octahedral_decode(glm::vec2 const& iCode);
+
+// C1 and C2 are the front and back slices of the C tensor
+PackedVertex pack_vertex(glm::vec3 const& iPosition, glm::vec3 const& iNormal, glm::vec3 const& iTangentU, glm::vec3 const& iT1, glm::vec3 const& iT2,
+	float iK1, float iK2, glm::mat2 const& iC1, glm::mat2 const& iC2);
+
+// packs every vertex of the streams into oVertex, which can be a mapped buffer
+void pack_vertices(ThreadPool& iPool, VertexStreams const& iStreams, PackedVertex* oVertex);